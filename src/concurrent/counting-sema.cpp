@@ -50,7 +50,8 @@ int main()
                 // Remove thread from 'enabled'
                 // Note that the same thread may acquire again after release
                 // because it would not have to do a context switch.
-                // For this reason scheduling can be unfair.
+                // For this reason scheduling can be unfair, FairSemaphore in
+                // fair-sema.h hands permits out in FIFO order instead.
                 enabled.release();
             }
         });
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+
+// Alignment that keeps independently written data on separate cache lines.
+inline constexpr std::size_t kNoSharing = 64;
+
+// Hint to the CPU that we're in a spin-wait loop.
+inline void CpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
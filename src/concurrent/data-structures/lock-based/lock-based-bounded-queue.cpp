@@ -1,77 +1,16 @@
-#include <condition_variable>
+#include "lock-based-bounded-queue.h"
+
+#include <array>
 #include <future>
 #include <iostream>
-#include <mutex>
-#include <optional>
-#include <queue>
+#include <numeric>
+#include <span>
 #include <syncstream>
 #include <thread>
+#include <vector>
 
 using namespace std::literals;
 
-template <typename T>
-class LockBasedBoundedQueue
-{
-public:
-    LockBasedBoundedQueue(size_t capacity) : capacity{std::max<size_t>(1, capacity)} {};
-
-    void Close()
-    {
-        {
-            std::lock_guard<std::mutex> lk{mut};
-            if (closed)
-                return;
-            closed = true;
-        }
-
-        cv_not_empty.notify_all();
-        cv_not_full.notify_all();
-    }
-
-    template <typename... Args>
-    bool WaitAndEmplace(Args&&... args)
-    {
-        {
-            std::unique_lock<std::mutex> lk{mut};
-            cv_not_full.wait(lk, [&]() { return queue.size() < capacity || closed; });
-            if (closed)
-                return false;
-
-            queue.emplace(std::forward<Args>(args)...);
-        }
-
-        cv_not_empty.notify_one();
-
-        return true;
-    }
-
-    std::optional<T> WaitAndPop()
-    {
-        std::optional<T> res;
-
-        {
-            std::unique_lock<std::mutex> lk{mut};
-            cv_not_empty.wait(lk, [&]() { return !queue.empty() || closed; });
-            if (queue.empty())
-                return std::nullopt;
-            res = std::move(queue.front());
-            queue.pop();
-        }
-
-        cv_not_full.notify_one();
-
-        return res;
-    }
-
-private:
-    bool closed = false;
-    size_t capacity;
-    std::queue<T> queue;
-    std::mutex mut;
-    std::condition_variable cv_not_empty;
-    std::condition_variable cv_not_full;
-};
-
 int main()
 {
     LockBasedBoundedQueue<int> Q1{5};
@@ -120,5 +59,44 @@ int main()
     for (int i = 0; i < N_CONSUMERS; ++i)
         consumers.emplace_back(std::async(std::launch::async, doConsume));
 
+    for (auto& producer : producers)
+        producer.get();
+    for (auto& consumer : consumers)
+        consumer.get();
+
+    // Bulk: bursts of items go in and out with one lock hold per batch.
+    LockBasedBoundedQueue<int> Q2{64};
+
+    auto bulkProducer = std::async(std::launch::async, [&]() {
+        std::vector<int> burst(100);
+        for (int round = 0; round < 10; ++round)
+        {
+            std::iota(burst.begin(), burst.end(), round * 100 + 1);
+            for (std::span<const int> pending{burst}; !pending.empty();)
+            {
+                const auto pushed = Q2.EmplaceBulk(pending);
+                if (pushed == 0)
+                    return;
+                pending = pending.subspan(pushed);
+            }
+        }
+        Q2.Close();
+    });
+
+    auto bulkConsumer = std::async(std::launch::async, [&]() {
+        std::array<int, 32> batch;
+        long sum = 0;
+        size_t batches = 0;
+        while (const auto count = Q2.WaitAndPopBulk(batch.begin(), batch.size()))
+        {
+            sum += std::accumulate(batch.begin(), batch.begin() + count, 0L);
+            ++batches;
+        }
+        std::osyncstream{std::cout} << "Bulk consumer: sum " << sum << " in " << batches << " batches\n";
+    });
+
+    bulkProducer.get();
+    bulkConsumer.get();
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <ranges>
+
+template <typename T>
+class LockBasedBoundedQueue
+{
+public:
+    LockBasedBoundedQueue(size_t capacity) : capacity{std::max<size_t>(1, capacity)} {};
+
+    void Close()
+    {
+        {
+            std::lock_guard<std::mutex> lk{mut};
+            if (closed)
+                return;
+            closed = true;
+        }
+
+        cv_not_empty.notify_all();
+        cv_not_full.notify_all();
+    }
+
+    template <typename... Args>
+    bool WaitAndEmplace(Args&&... args)
+    {
+        bool notify = false;
+        {
+            std::unique_lock<std::mutex> lk{mut};
+            WaitFor(lk, cv_not_full, notFullWaiters, [&]() { return queue.size() < capacity || closed; });
+            if (closed)
+                return false;
+
+            queue.emplace(std::forward<Args>(args)...);
+            notify = notEmptyWaiters != 0;
+        }
+
+        if (notify)
+            cv_not_empty.notify_one();
+
+        return true;
+    }
+
+    // Waits for a free slot and emplaces as many leading elements of the range as fit under one lock hold.
+    // Returns the number of elements taken, 0 when the queue is closed. An empty range returns 0 at once.
+    template <std::ranges::input_range Range>
+    size_t EmplaceBulk(Range&& range)
+    {
+        auto it = std::ranges::begin(range);
+        const auto end = std::ranges::end(range);
+        if (it == end)
+            return 0;
+
+        size_t count = 0;
+        size_t waiting = 0;
+        {
+            std::unique_lock<std::mutex> lk{mut};
+            WaitFor(lk, cv_not_full, notFullWaiters, [&]() { return queue.size() < capacity || closed; });
+            if (closed)
+                return 0;
+
+            for (; it != end && queue.size() < capacity; ++it, ++count)
+                queue.emplace(*it);
+            waiting = notEmptyWaiters;
+        }
+
+        NotifyBatch(cv_not_empty, count, waiting);
+
+        return count;
+    }
+
+    std::optional<T> WaitAndPop()
+    {
+        std::optional<T> res;
+        bool notify = false;
+        {
+            std::unique_lock<std::mutex> lk{mut};
+            WaitFor(lk, cv_not_empty, notEmptyWaiters, [&]() { return !queue.empty() || closed; });
+            if (queue.empty())
+                return std::nullopt;
+            res = std::move(queue.front());
+            queue.pop();
+            notify = notFullWaiters != 0;
+        }
+
+        if (notify)
+            cv_not_full.notify_one();
+
+        return res;
+    }
+
+    // Waits for at least one item and moves up to maxN items to out under one lock hold.
+    // Returns the number of items popped, 0 when the queue is closed and drained. maxN == 0 returns 0 at once.
+    template <std::output_iterator<T> OutputIt>
+    size_t WaitAndPopBulk(OutputIt out, size_t maxN)
+    {
+        if (maxN == 0)
+            return 0;
+
+        size_t count = 0;
+        size_t waiting = 0;
+        {
+            std::unique_lock<std::mutex> lk{mut};
+            WaitFor(lk, cv_not_empty, notEmptyWaiters, [&]() { return !queue.empty() || closed; });
+            for (; count < maxN && !queue.empty(); ++count)
+            {
+                *out++ = std::move(queue.front());
+                queue.pop();
+            }
+            waiting = notFullWaiters;
+        }
+
+        NotifyBatch(cv_not_full, count, waiting);
+
+        return count;
+    }
+
+private:
+    // Counts the waiters so the notifying side can skip the notify call when nobody waits.
+    template <typename Predicate>
+    void WaitFor(std::unique_lock<std::mutex>& lk, std::condition_variable& cv, size_t& waiters, Predicate ready)
+    {
+        if (ready())
+            return;
+
+        ++waiters;
+        cv.wait(lk, ready);
+        --waiters;
+    }
+
+    // A batch of count items unblocks at most count of the waiters counted under the lock. One notify_all when it
+    // unblocks all of them, otherwise one notify_one per item so the waiters it can't serve keep sleeping.
+    static void NotifyBatch(std::condition_variable& cv, size_t count, size_t waiters)
+    {
+        if (waiters == 0)
+            return;
+
+        if (count >= waiters)
+        {
+            cv.notify_all();
+            return;
+        }
+
+        for (size_t i = 0; i < count; ++i)
+            cv.notify_one();
+    }
+
+    bool closed = false;
+    size_t capacity;
+    size_t notEmptyWaiters = 0;
+    size_t notFullWaiters = 0;
+    std::queue<T> queue;
+    std::mutex mut;
+    std::condition_variable cv_not_empty;
+    std::condition_variable cv_not_full;
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+template <typename T>
+class ThreadSafeQueue
+{
+public:
+    // Creates a dummy node that separates head/tail
+    // Preallocates nodes, so the first pushes don't allocate either.
+    explicit ThreadSafeQueue(size_t preallocate = 64, size_t maxCached = 1024)
+        : head{std::make_unique<Node>(T{})}, tail{head.get()}, maxCached{std::max(preallocate, maxCached)}
+    {
+        for (size_t i = 0; i < preallocate; ++i)
+            Recycle(std::make_unique<Node>(T{}));
+    }
+
+    ~ThreadSafeQueue()
+    {
+        for (auto* node = freeList.load(std::memory_order_relaxed); node != nullptr;)
+            delete std::exchange(node, node->nextFree);
+    }
+
+    ThreadSafeQueue(const ThreadSafeQueue&) = delete;
+    ThreadSafeQueue& operator=(const ThreadSafeQueue&) = delete;
+
+    bool Empty()
+    {
+        std::lock_guard<std::mutex> lk{headMut};
+        return head.get() == GetTail();
+    }
+
+    std::optional<T> TryPop()
+    {
+        auto oldHead = PopHead();
+        if (!oldHead)
+            return std::nullopt;
+
+        std::optional<T> res{std::move(oldHead->data)};
+        Recycle(std::move(oldHead));
+        return res;
+    }
+
+    void Push(T data)
+    {
+        std::lock_guard<std::mutex> lk{tailMut};
+
+        tail->data = std::move(data);
+        tail->next = AcquireNode();
+        tail = tail->next.get();
+    }
+
+private:
+    struct Node
+    {
+        Node(T data) : data{std::move(data)}
+        {
+        }
+
+        T data;
+        std::unique_ptr<Node> next;
+        Node* nextFree = nullptr;
+    };
+
+    Node* GetTail()
+    {
+        std::lock_guard<std::mutex> lk{tailMut};
+        return tail;
+    }
+
+    std::unique_ptr<Node> PopHead()
+    {
+        std::lock_guard<std::mutex> lk{headMut};
+
+        if (head.get() == GetTail()) // Head, Tail point to the dummy node, the list is empty
+            return nullptr;
+
+        auto oldHead = std::move(head);
+        head = std::move(oldHead->next);
+        return oldHead;
+    }
+
+    // Freelist of popped nodes, a Treiber stack.
+    // Any thread may push, but only the producer holding tailMut pops, so a node can't be popped and pushed
+    // back between a pop's load and its CAS (no ABA).
+    std::unique_ptr<Node> AcquireNode()
+    {
+        auto* node = freeList.load(std::memory_order_acquire);
+        while (node != nullptr &&
+               !freeList.compare_exchange_weak(node, node->nextFree, std::memory_order_acquire,
+                                               std::memory_order_acquire))
+            ;
+
+        if (node == nullptr)
+            return std::make_unique<Node>(T{});
+
+        cached.fetch_sub(1, std::memory_order_relaxed);
+        return std::unique_ptr<Node>{node};
+    }
+
+    void Recycle(std::unique_ptr<Node> node)
+    {
+        // Over the cap the node is freed, the count is a hint so the cap may be overshot by a few nodes.
+        if (cached.load(std::memory_order_relaxed) >= maxCached)
+            return;
+
+        cached.fetch_add(1, std::memory_order_relaxed);
+        auto* raw = node.release();
+        raw->nextFree = freeList.load(std::memory_order_relaxed);
+        while (!freeList.compare_exchange_weak(raw->nextFree, raw, std::memory_order_release,
+                                               std::memory_order_relaxed))
+            ;
+    }
+
+    std::mutex headMut;
+    std::unique_ptr<Node> head;
+
+    std::mutex tailMut;
+    Node* tail = nullptr;
+
+    const size_t maxCached;
+    std::atomic<Node*> freeList{nullptr};
+    std::atomic_size_t cached{0};
+};
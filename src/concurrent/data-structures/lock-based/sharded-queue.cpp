@@ -0,0 +1,61 @@
+#include "sharded-queue.h"
+
+#include <atomic>
+#include <future>
+#include <iostream>
+#include <vector>
+
+int main()
+{
+    constexpr int N_PRODUCERS = 8;
+    constexpr int N_CONSUMERS = 4;
+    constexpr int N_ITEMS = 20'000;
+
+    struct Item
+    {
+        int producer;
+        int seq;
+    };
+
+    ShardedQueue<Item> queue{4};
+
+    std::vector<std::future<void>> producers;
+    producers.reserve(N_PRODUCERS);
+    for (int p = 0; p < N_PRODUCERS; ++p)
+        producers.emplace_back(std::async(std::launch::async, [&queue, p]() {
+            for (int i = 0; i < N_ITEMS; ++i)
+                queue.Push(Item{p, i});
+        }));
+
+    // Every consumer checks that the items of each producer arrive in order.
+    std::atomic_int popped{0};
+    std::vector<std::future<bool>> consumers;
+    consumers.reserve(N_CONSUMERS);
+    for (int c = 0; c < N_CONSUMERS; ++c)
+        consumers.emplace_back(std::async(std::launch::async, [&queue, &popped]() {
+            std::vector<int> last(N_PRODUCERS, -1);
+            bool inOrder = true;
+            while (auto item = queue.WaitAndPop())
+            {
+                inOrder &= item->seq > last[item->producer];
+                last[item->producer] = item->seq;
+                popped.fetch_add(1, std::memory_order_relaxed);
+            }
+            return inOrder;
+        }));
+
+    for (auto& producer : producers)
+        producer.get();
+
+    std::cout << "Closing with " << queue.Size() << " items queued in " << queue.ShardCount() << " shards...\n";
+    queue.Close();
+
+    bool inOrder = true;
+    for (auto& consumer : consumers)
+        inOrder &= consumer.get();
+
+    std::cout << "popped " << popped << " of " << N_PRODUCERS * N_ITEMS << ", per producer order "
+              << (inOrder ? "kept" : "BROKEN") << ", push after close " << queue.Push(Item{}) << '\n';
+
+    return inOrder && popped == N_PRODUCERS * N_ITEMS ? 0 : 1;
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "../../cpu.h"
+
+// Unbounded MPMC queue split into independently locked shards, so producers don't share one hot head/tail.
+// - Every thread gets a sticky home shard on first use. A producer always pushes to its home shard, so its
+//   items keep their order (per-producer FIFO); there is no global FIFO order across producers.
+// - Consumers pop from their home shard first, then steal from the front of the others.
+// - Blocking pops sleep on an eventcount, producers only notify when a consumer sleeps.
+template <typename T>
+class ShardedQueue
+{
+public:
+    explicit ShardedQueue(size_t shardCount = std::max(1u, std::thread::hardware_concurrency()))
+    {
+        shards.reserve(std::max<size_t>(1, shardCount));
+        for (size_t i = 0; i < std::max<size_t>(1, shardCount); ++i)
+            shards.push_back(std::make_unique<Shard>());
+    }
+
+    ShardedQueue(const ShardedQueue&) = delete;
+    ShardedQueue& operator=(const ShardedQueue&) = delete;
+
+    [[nodiscard]] size_t ShardCount() const
+    {
+        return shards.size();
+    }
+
+    // Approximate unless the queue is quiescent.
+    [[nodiscard]] size_t Size() const
+    {
+        size_t size = 0;
+        for (const auto& shard : shards)
+            size += shard->size.load(std::memory_order_relaxed);
+        return size;
+    }
+
+    void Close()
+    {
+        if (closed.exchange(true, std::memory_order_seq_cst))
+            return;
+
+        epoch.fetch_add(1, std::memory_order_release);
+        epoch.notify_all();
+    }
+
+    // Returns false once the queue is closed.
+    template <typename... Args>
+    bool Emplace(Args&&... args)
+    {
+        if (closed.load(std::memory_order_acquire))
+            return false;
+
+        auto& shard = *shards[Home()];
+        {
+            std::lock_guard<std::mutex> lk{shard.mut};
+            // Checked again under the lock, a consumer's drain pass takes every shard lock after it saw closed.
+            if (closed.load(std::memory_order_acquire))
+                return false;
+
+            shard.items.emplace_back(std::forward<Args>(args)...);
+            shard.size.fetch_add(1, std::memory_order_seq_cst);
+        }
+
+        if (waiters.load(std::memory_order_seq_cst) != 0)
+        {
+            epoch.fetch_add(1, std::memory_order_release);
+            epoch.notify_one();
+        }
+
+        return true;
+    }
+
+    bool Push(T val)
+    {
+        return Emplace(std::move(val));
+    }
+
+    std::optional<T> TryPop()
+    {
+        const auto home = Home();
+        for (size_t i = 0; i < shards.size(); ++i)
+            if (auto val = TryPopShard(*shards[(home + i) % shards.size()]))
+                return val;
+
+        return std::nullopt;
+    }
+
+    // Returns std::nullopt once the queue is closed and drained.
+    std::optional<T> WaitAndPop()
+    {
+        for (;;)
+        {
+            if (auto val = TryPop())
+                return val;
+
+            if (closed.load(std::memory_order_acquire))
+                return Drain();
+
+            const auto current = epoch.load(std::memory_order_acquire);
+            waiters.fetch_add(1, std::memory_order_seq_cst);
+            if (!closed.load(std::memory_order_seq_cst) && AllEmpty())
+                epoch.wait(current, std::memory_order_acquire);
+            waiters.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    struct alignas(kNoSharing) Shard
+    {
+        std::mutex mut;
+        std::deque<T> items;
+        // Readable without the lock, lets consumers skip empty shards and sleep when all are empty.
+        std::atomic_size_t size{0};
+    };
+
+    size_t Home() const
+    {
+        thread_local const size_t threadIndex = nextThreadIndex.fetch_add(1, std::memory_order_relaxed);
+        return threadIndex % shards.size();
+    }
+
+    std::optional<T> TryPopShard(Shard& shard)
+    {
+        if (shard.size.load(std::memory_order_relaxed) == 0)
+            return std::nullopt;
+
+        std::lock_guard<std::mutex> lk{shard.mut};
+        if (shard.items.empty())
+            return std::nullopt;
+
+        std::optional<T> res{std::move(shard.items.front())};
+        shard.items.pop_front();
+        shard.size.fetch_sub(1, std::memory_order_relaxed);
+        return res;
+    }
+
+    // A push that saw the queue open under a shard lock released that lock before we take it here, a later
+    // push sees closed under the lock and fails. So a pass that locks every shard finds every accepted item,
+    // the lock-free size check of TryPopShard() could miss one.
+    std::optional<T> Drain()
+    {
+        for (auto& shard : shards)
+        {
+            std::lock_guard<std::mutex> lk{shard->mut};
+            if (!shard->items.empty())
+            {
+                std::optional<T> res{std::move(shard->items.front())};
+                shard->items.pop_front();
+                shard->size.fetch_sub(1, std::memory_order_relaxed);
+                return res;
+            }
+        }
+
+        return std::nullopt;
+    }
+
+    // A push's seq_cst size increment is followed by a seq_cst load of waiters, and a waiter registers
+    // before this check, so either we see the item or the producer sees us and bumps the epoch.
+    bool AllEmpty() const
+    {
+        return std::ranges::all_of(shards, [](const auto& shard) {
+            return shard->size.load(std::memory_order_seq_cst) == 0;
+        });
+    }
+
+    static inline std::atomic_size_t nextThreadIndex{0};
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    alignas(kNoSharing) std::atomic_bool closed{false};
+    std::atomic_uint32_t epoch{0};
+    std::atomic_uint32_t waiters{0};
+};
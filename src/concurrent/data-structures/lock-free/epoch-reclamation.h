@@ -0,0 +1,149 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "thread-record-registry.h"
+
+// Source: K. Fraser, Practical lock-freedom, chapter 5.2.3
+
+// Epoch based reclamation: memory unlinked from a lock-free structure is freed only after every thread
+// that could still see it has left its critical section.
+// - A thread pins the current global epoch while it holds a Guard.
+// - The global epoch advances only when every pinned thread has seen it.
+// - Objects retired in epoch e are freed once the global epoch reaches e + 2.
+// Entering a Guard costs one atomic exchange, a stalled reader delays reclamation but never blocks writers.
+class EpochDomain
+{
+    struct Record;
+
+public:
+    class Guard
+    {
+    public:
+        explicit Guard(EpochDomain& domain) : record{&domain.registry.Local()}
+        {
+            // Order matters: the pin must be visible before we read any shared pointer. An RMW instead of
+            // store + fence also continues the release sequence of the last unpin, TSan doesn't model fences.
+            if (record->nesting++ == 0)
+                record->epoch.exchange(domain.globalEpoch.load(std::memory_order_seq_cst) | kActive,
+                                       std::memory_order_seq_cst);
+        }
+
+        ~Guard()
+        {
+            if (--record->nesting == 0)
+                record->epoch.store(0, std::memory_order_release);
+        }
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+    private:
+        Record* record;
+    };
+
+    EpochDomain() = default;
+
+    // No thread may use the domain anymore, frees everything that is still retired.
+    ~EpochDomain()
+    {
+        for (auto* record = registry.Head(); record != nullptr; record = record->next)
+            for (auto& retired : record->retired)
+                retired.deleter(retired.ptr);
+    }
+
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+
+    // Frees ptr with delete once no Guard taken before this call can still be reading it.
+    template <typename T>
+    void Retire(T* ptr)
+    {
+        Retire(ptr, [](void* p) { delete static_cast<T*>(p); });
+    }
+
+    void Retire(void* ptr, void (*deleter)(void*))
+    {
+        auto& record = registry.Local();
+        record.retired.push_back({ptr, deleter, globalEpoch.load(std::memory_order_acquire)});
+        if (record.retired.size() % kCollectThreshold == 0)
+        {
+            TryAdvance();
+            Collect(record);
+        }
+    }
+
+    // Waits for a full grace period and frees what this thread has retired.
+    // Must not be called while holding a Guard.
+    void Synchronize()
+    {
+        const auto target = globalEpoch.load(std::memory_order_acquire) + 2 * kEpochStep;
+        while (globalEpoch.load(std::memory_order_acquire) < target)
+            if (!TryAdvance())
+                std::this_thread::yield();
+
+        Collect(registry.Local());
+    }
+
+private:
+    // The low bit of a record's epoch marks it as pinned, the epoch itself counts in steps of 2.
+    static constexpr std::uint64_t kActive = 1;
+    static constexpr std::uint64_t kEpochStep = 2;
+    static constexpr std::size_t kCollectThreshold = 64;
+
+    struct Retired
+    {
+        void* ptr;
+        void (*deleter)(void*);
+        std::uint64_t epoch;
+    };
+
+    // One per thread and domain, handed over to another thread when its owner exits.
+    struct alignas(kNoSharing) Record
+    {
+        std::atomic_uint64_t epoch{0};
+        std::atomic_bool owned{true};
+        std::size_t nesting = 0;      // only owner can access
+        std::vector<Retired> retired; // only owner can access
+        Record* next = nullptr;
+    };
+
+    // Advances the global epoch if every pinned thread has already seen it.
+    bool TryAdvance()
+    {
+        auto current = globalEpoch.load(std::memory_order_seq_cst);
+        for (auto* record = registry.Head(); record != nullptr; record = record->next)
+        {
+            const auto epoch = record->epoch.load(std::memory_order_seq_cst);
+            if ((epoch & kActive) != 0 && (epoch & ~kActive) != current)
+                return false;
+        }
+
+        return globalEpoch.compare_exchange_strong(current, current + kEpochStep, std::memory_order_seq_cst);
+    }
+
+    void Collect(Record& record)
+    {
+        const auto safe = globalEpoch.load(std::memory_order_acquire);
+        std::size_t freed = 0;
+        while (freed < record.retired.size() && record.retired[freed].epoch + 2 * kEpochStep <= safe)
+        {
+            record.retired[freed].deleter(record.retired[freed].ptr);
+            ++freed;
+        }
+        record.retired.erase(record.retired.begin(), record.retired.begin() + freed);
+    }
+
+    alignas(kNoSharing) std::atomic_uint64_t globalEpoch{0};
+    ThreadRecordRegistry<Record> registry;
+};
+
+inline EpochDomain& DefaultEpochDomain()
+{
+    static EpochDomain domain;
+    return domain;
+}
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "thread-record-registry.h"
+
+// Source: M. Michael, Hazard Pointers: Safe Memory Reclamation for Lock-Free Objects
+// Interface modeled on P2530 std::hazard_pointer.
+
+// Hazard pointers: a reader publishes the pointer it is about to dereference in one of its hazard slots, a
+// retired object is freed only when no slot holds it.
+// - Every thread owns a record of kSlots hazard slots per domain, taking a HazardPointer is a bit flip.
+// - Retired objects go to the retiring thread's list, the list is scanned against all slots once it passes
+//   a threshold proportional to the number of slots, so a scan frees most of what it looks at.
+// - Unlike EpochDomain a stalled reader only keeps the objects it protects alive.
+// Separate domains keep separate records and retire lists, subsystems don't scan each other's.
+class HazardPointerDomain;
+
+class HazardPointer
+{
+public:
+    // An empty hazard pointer, protects nothing.
+    HazardPointer() = default;
+
+    HazardPointer(HazardPointer&& other) noexcept
+        : hazard{std::exchange(other.hazard, nullptr)}, freeSlots{other.freeSlots}, slotBit{other.slotBit}
+    {
+    }
+
+    HazardPointer& operator=(HazardPointer&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Release();
+            hazard = std::exchange(other.hazard, nullptr);
+            freeSlots = other.freeSlots;
+            slotBit = other.slotBit;
+        }
+        return *this;
+    }
+
+    ~HazardPointer()
+    {
+        Release();
+    }
+
+    [[nodiscard]] bool Empty() const noexcept
+    {
+        return hazard == nullptr;
+    }
+
+    // Loads src until the loaded pointer is protected, the result stays valid until the protection is reset.
+    template <typename T>
+    T* Protect(const std::atomic<T*>& src) noexcept
+    {
+        auto* ptr = src.load(std::memory_order_relaxed);
+        while (!TryProtect(ptr, src))
+            ;
+        return ptr;
+    }
+
+    // Protects ptr if src still holds it, otherwise stores the current value of src in ptr and returns false.
+    template <typename T>
+    bool TryProtect(T*& ptr, const std::atomic<T*>& src) noexcept
+    {
+        auto* expected = ptr;
+        ResetProtection(expected);
+        // Order matters: the hazard must be visible to scanners before we re-check src.
+        ptr = src.load(std::memory_order_seq_cst);
+        if (ptr != expected)
+        {
+            ResetProtection();
+            return false;
+        }
+        return true;
+    }
+
+    template <typename T>
+    void ResetProtection(const T* ptr) noexcept
+    {
+        hazard->store(ptr, std::memory_order_seq_cst);
+    }
+
+    void ResetProtection(std::nullptr_t = nullptr) noexcept
+    {
+        hazard->store(nullptr, std::memory_order_release);
+    }
+
+private:
+    friend class HazardPointerDomain;
+
+    HazardPointer(std::atomic<const void*>* hazard, std::uint32_t* freeSlots, std::uint32_t slotBit)
+        : hazard{hazard}, freeSlots{freeSlots}, slotBit{slotBit}
+    {
+    }
+
+    void Release() noexcept
+    {
+        if (hazard == nullptr)
+            return;
+
+        ResetProtection();
+        *freeSlots |= slotBit;
+        hazard = nullptr;
+    }
+
+    std::atomic<const void*>* hazard = nullptr;
+    std::uint32_t* freeSlots = nullptr; // only owner thread can access
+    std::uint32_t slotBit = 0;
+};
+
+class HazardPointerDomain
+{
+    struct Record;
+
+public:
+    HazardPointerDomain() = default;
+
+    // No thread may use the domain anymore, frees everything that is still retired.
+    ~HazardPointerDomain()
+    {
+        for (auto* record = registry.Head(); record != nullptr; record = record->next)
+            for (auto& retired : record->retired)
+                retired.deleter(retired.ptr);
+    }
+
+    HazardPointerDomain(const HazardPointerDomain&) = delete;
+    HazardPointerDomain& operator=(const HazardPointerDomain&) = delete;
+
+    // A hazard pointer of the calling thread, must be destroyed on that thread.
+    HazardPointer MakeHazardPointer()
+    {
+        // With all slots of this thread taken, the registry hands out another record.
+        return TakeSlot(registry.Local([](const Record& record) { return record.freeSlots != 0; }));
+    }
+
+    // Frees ptr with delete once no hazard pointer protects it. ptr must be unlinked already.
+    template <typename T>
+    void Retire(T* ptr)
+    {
+        Retire(ptr, [](void* p) { delete static_cast<T*>(p); });
+    }
+
+    void Retire(void* ptr, void (*deleter)(void*))
+    {
+        // The thread's first record keeps its retire list.
+        auto& record = registry.Local();
+        record.retired.push_back({ptr, deleter});
+        if (record.retired.size() >= ScanThreshold())
+            Scan(record);
+    }
+
+    // Frees everything this thread has retired that is not protected right now.
+    void Reclaim()
+    {
+        Scan(registry.Local());
+    }
+
+private:
+    static constexpr std::size_t kSlots = 8;
+    static constexpr std::size_t kScanThreshold = 64;
+
+    struct Retired
+    {
+        void* ptr;
+        void (*deleter)(void*);
+    };
+
+    // kSlots hazard slots of one thread, handed over to another thread when its owner exits.
+    struct alignas(kNoSharing) Record
+    {
+        std::array<std::atomic<const void*>, kSlots> hazards{};
+        std::atomic_bool owned{true};
+        std::uint32_t freeSlots = (1u << kSlots) - 1; // only owner can access
+        std::vector<Retired> retired;                 // only owner can access
+        Record* next = nullptr;
+    };
+
+    static HazardPointer TakeSlot(Record& record)
+    {
+        const auto slot = static_cast<std::size_t>(std::countr_zero(record.freeSlots));
+        const auto slotBit = 1u << slot;
+        record.freeSlots &= ~slotBit;
+        return HazardPointer{&record.hazards[slot], &record.freeSlots, slotBit};
+    }
+
+    std::size_t ScanThreshold() const
+    {
+        return std::max(kScanThreshold, 2 * kSlots * registry.Size());
+    }
+
+    // Frees the retired objects of record that no slot protects.
+    void Scan(Record& record)
+    {
+        std::vector<const void*> protectedPtrs;
+        for (auto* other = registry.Head(); other != nullptr; other = other->next)
+            for (const auto& hazard : other->hazards)
+                if (const auto* ptr = hazard.load(std::memory_order_seq_cst); ptr != nullptr)
+                    protectedPtrs.push_back(ptr);
+        std::ranges::sort(protectedPtrs);
+
+        std::erase_if(record.retired, [&](const Retired& retired) {
+            if (std::ranges::binary_search(protectedPtrs, static_cast<const void*>(retired.ptr)))
+                return false;
+            retired.deleter(retired.ptr);
+            return true;
+        });
+    }
+
+    ThreadRecordRegistry<Record> registry;
+};
+
+inline HazardPointerDomain& DefaultHazardPointerDomain()
+{
+    static HazardPointerDomain domain;
+    return domain;
+}
+
+inline HazardPointer MakeHazardPointer(HazardPointerDomain& domain = DefaultHazardPointerDomain())
+{
+    return domain.MakeHazardPointer();
+}
+
+// Base class of objects retired through hazard pointers, as std::hazard_pointer_obj_base.
+template <typename T, typename Deleter = std::default_delete<T>>
+class HazardPointerObjBase
+{
+public:
+    // Frees the object with Deleter once no hazard pointer protects it. The object must be unlinked already.
+    void Retire(HazardPointerDomain& domain = DefaultHazardPointerDomain())
+    {
+        domain.Retire(static_cast<T*>(this), [](void* p) { Deleter{}(static_cast<T*>(p)); });
+    }
+
+protected:
+    HazardPointerObjBase() = default;
+    ~HazardPointerObjBase() = default;
+};
@@ -0,0 +1,73 @@
+#include "lock-free-bounded-queue.h"
+
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <iostream>
+#include <syncstream>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+
+int main()
+{
+    LockFreeBoundedQueue<int> Q1{5};
+
+    const int N_ITEMS = 50;
+    const auto doProduce = [&]() {
+        const auto tid = std::this_thread::get_id();
+        for (int i = 1; i <= N_ITEMS; ++i)
+        {
+            std::osyncstream{std::cout} << tid << " pushing " << i << "...\n";
+            if (!Q1.WaitAndEmplace(i))
+            {
+                std::osyncstream{std::cout} << tid << " can't push anymore!\n";
+                return;
+            }
+        }
+    };
+
+    std::atomic_int consumed{0};
+    const auto doConsume = [&]() {
+        const auto tid = std::this_thread::get_id();
+        while (true)
+        {
+            auto val = Q1.WaitAndPop();
+            if (!val)
+            {
+                std::osyncstream{std::cout} << tid << " Queue closed!\n";
+                break;
+            }
+
+            consumed += *val;
+            std::osyncstream{std::cout} << tid << " WaitAndPop -> " << *val << '\n';
+            std::this_thread::sleep_for(5ms);
+        }
+    };
+
+    const size_t N_PRODUCERS = 5;
+    std::vector<std::future<void>> producers;
+    producers.reserve(N_PRODUCERS);
+    for (std::size_t i = 0; i < N_PRODUCERS; ++i)
+        producers.emplace_back(std::async(std::launch::async, doProduce));
+
+    const size_t N_CONSUMERS = 15;
+    std::vector<std::future<void>> consumers;
+    consumers.reserve(N_CONSUMERS);
+    for (std::size_t i = 0; i < N_CONSUMERS; ++i)
+        consumers.emplace_back(std::async(std::launch::async, doConsume));
+
+    for (auto& producer : producers)
+        producer.get();
+
+    std::osyncstream{std::cout} << "Closing...\n";
+    Q1.Close();
+
+    for (auto& consumer : consumers)
+        consumer.get();
+
+    std::cout << "Consumed sum " << consumed << ", expected " << N_PRODUCERS * N_ITEMS * (N_ITEMS + 1) / 2 << '\n';
+
+    return 0;
+}
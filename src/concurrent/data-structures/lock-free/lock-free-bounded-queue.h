@@ -0,0 +1,270 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "../../cpu.h"
+
+// Source: https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+
+// Bounded MPMC queue with the same API as LockBasedBoundedQueue.
+// Every cell carries a sequence number that tells producers and consumers whose turn it is:
+// - sequence == pos: free, the producer that claims pos (CAS on enqueuePos) may write it.
+// - sequence == pos + 1: full, the consumer that claims pos (CAS on dequeuePos) may read it.
+// After reading, the consumer sets sequence to pos + capacity, the producer's pos one lap later.
+// Close() sets the top bit of enqueuePos, so a producer's claim and its closed check are the same CAS: every
+// claim happens before Close() and consumers drain up to the final enqueuePos.
+// Threads only block (std::atomic::wait) when the queue is empty or full after a short spin.
+template <typename T>
+class LockFreeBoundedQueue
+{
+public:
+    // The capacity is rounded up to a power of two.
+    LockFreeBoundedQueue(size_t capacity)
+        : capacity{std::bit_ceil(std::max<size_t>(2, capacity))}, mask{this->capacity - 1},
+          cells{std::make_unique<Cell[]>(this->capacity)}
+    {
+        for (size_t i = 0; i < this->capacity; ++i)
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    ~LockFreeBoundedQueue()
+    {
+        while (TryPop())
+            ;
+    }
+
+    LockFreeBoundedQueue(const LockFreeBoundedQueue&) = delete;
+    LockFreeBoundedQueue& operator=(const LockFreeBoundedQueue&) = delete;
+
+    void Close()
+    {
+        if ((enqueuePos.fetch_or(kClosed, std::memory_order_seq_cst) & kClosed) != 0)
+            return;
+
+        notEmpty.epoch.fetch_add(1, std::memory_order_release);
+        notEmpty.epoch.notify_all();
+        notFull.epoch.fetch_add(1, std::memory_order_release);
+        notFull.epoch.notify_all();
+    }
+
+    template <typename... Args>
+    bool WaitAndEmplace(Args&&... args)
+    {
+        for (unsigned spins = 0;; ++spins)
+        {
+            if (TryEmplace(std::forward<Args>(args)...))
+                return true;
+
+            if (Closed())
+                return false;
+
+            if (spins < kSpinCount)
+            {
+                CpuRelax();
+                continue;
+            }
+
+            // Sleep only if there's no free slot that a consumer hasn't handed back yet.
+            notFull.Wait([this]() {
+                const auto enqueue = enqueuePos.load(std::memory_order_seq_cst);
+                return (enqueue & kClosed) != 0 || enqueue - dequeuePos.load(std::memory_order_seq_cst) < capacity;
+            });
+            spins = 0;
+        }
+    }
+
+    std::optional<T> WaitAndPop()
+    {
+        for (unsigned spins = 0;; ++spins)
+        {
+            if (auto res = TryPop())
+                return res;
+
+            if (Closed())
+                return Drain();
+
+            if (spins < kSpinCount)
+            {
+                CpuRelax();
+                continue;
+            }
+
+            // Sleep only if no producer has claimed a slot we haven't consumed yet.
+            notEmpty.Wait([this]() {
+                const auto enqueue = enqueuePos.load(std::memory_order_seq_cst);
+                return (enqueue & kClosed) != 0 || enqueue != dequeuePos.load(std::memory_order_seq_cst);
+            });
+            spins = 0;
+        }
+    }
+
+    // Returns false when the queue is full or closed.
+    template <typename... Args>
+    bool TryEmplace(Args&&... args)
+    {
+        if constexpr (std::is_nothrow_constructible_v<T, Args...>)
+        {
+            return TryPush([&](void* storage) { ::new (storage) T(std::forward<Args>(args)...); });
+        }
+        else
+        {
+            // A constructor that throws after we claimed a cell would leave a hole in the queue.
+            T val(std::forward<Args>(args)...);
+            return TryPush([&](void* storage) { ::new (storage) T(std::move(val)); });
+        }
+    }
+
+    std::optional<T> TryPop()
+    {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        Cell* cell = nullptr;
+        for (;;)
+        {
+            cell = &cells[pos & mask];
+            const size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+            if (diff == 0)
+            {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_seq_cst,
+                                                     std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                return std::nullopt; // Empty
+            }
+            else
+            {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        auto* val = std::launder(reinterpret_cast<T*>(cell->storage));
+        std::optional<T> res{std::move(*val)};
+        val->~T();
+        cell->sequence.store(pos + capacity, std::memory_order_release);
+
+        notFull.Notify();
+        return res;
+    }
+
+private:
+    static constexpr unsigned kSpinCount = 64;
+    static constexpr size_t kClosed = size_t{1} << (sizeof(size_t) * 8 - 1);
+
+    bool Closed() const
+    {
+        return (enqueuePos.load(std::memory_order_seq_cst) & kClosed) != 0;
+    }
+
+    // After Close() no position can be claimed anymore, pops until dequeuePos reaches the final enqueuePos.
+    // A producer that claimed a slot before Close() may still be writing it, we wait for it to publish.
+    std::optional<T> Drain()
+    {
+        const auto last = enqueuePos.load(std::memory_order_seq_cst) & ~kClosed;
+        for (unsigned spins = 0;; ++spins)
+        {
+            if (auto res = TryPop())
+                return res;
+
+            if (dequeuePos.load(std::memory_order_seq_cst) == last)
+                return std::nullopt;
+
+            if (spins < kSpinCount)
+                CpuRelax();
+            else
+                std::this_thread::yield();
+        }
+    }
+
+    struct Cell
+    {
+        std::atomic_size_t sequence{0};
+        alignas(T) std::byte storage[sizeof(T)];
+    };
+
+    // Eventcount: a waiter registers, re-checks its condition and sleeps on the epoch.
+    // Every queue position change is a seq_cst CAS followed by a seq_cst load of waiters, so either
+    // the waiter's re-check sees the change or the notifier sees the waiter and bumps the epoch.
+    struct alignas(kNoSharing) WaitPoint
+    {
+        template <typename Predicate>
+        void Wait(Predicate ready)
+        {
+            const auto current = epoch.load(std::memory_order_acquire);
+            waiters.fetch_add(1, std::memory_order_seq_cst);
+            if (!ready())
+                epoch.wait(current, std::memory_order_acquire);
+            waiters.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        void Notify()
+        {
+            if (waiters.load(std::memory_order_seq_cst) == 0)
+                return;
+
+            epoch.fetch_add(1, std::memory_order_release);
+            epoch.notify_one();
+        }
+
+        std::atomic_uint32_t epoch{0};
+        std::atomic_uint32_t waiters{0};
+    };
+
+    template <typename Construct>
+    bool TryPush(Construct construct)
+    {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        Cell* cell = nullptr;
+        for (;;)
+        {
+            // A failed CAS reloads pos, so a Close() that lands between our load and the CAS is seen here.
+            if ((pos & kClosed) != 0)
+                return false;
+
+            cell = &cells[pos & mask];
+            const size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_seq_cst,
+                                                     std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                return false; // Full
+            }
+            else
+            {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        construct(static_cast<void*>(cell->storage));
+        cell->sequence.store(pos + 1, std::memory_order_release);
+
+        notEmpty.Notify();
+        return true;
+    }
+
+    const size_t capacity;
+    const size_t mask;
+    std::unique_ptr<Cell[]> cells;
+
+    // The top bit of enqueuePos is the closed flag.
+    alignas(kNoSharing) std::atomic_size_t enqueuePos{0};
+    alignas(kNoSharing) std::atomic_size_t dequeuePos{0};
+    WaitPoint notEmpty;
+    WaitPoint notFull;
+};
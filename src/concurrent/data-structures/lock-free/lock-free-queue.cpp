@@ -0,0 +1,66 @@
+#include "lock-free-queue.h"
+
+#include <atomic>
+#include <future>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+int main()
+{
+    // Stress test: every consumer checks that the values of each producer arrive in order.
+    constexpr int N_PRODUCERS = 4;
+    constexpr int N_CONSUMERS = 4;
+    constexpr int N_ITEMS = 50'000;
+
+    struct Item
+    {
+        int producer;
+        int seq;
+    };
+
+    LockFreeQueue<Item> queue;
+
+    std::vector<std::future<void>> producers;
+    producers.reserve(N_PRODUCERS);
+    for (int p = 0; p < N_PRODUCERS; ++p)
+        producers.emplace_back(std::async(std::launch::async, [&queue, p]() {
+            for (int i = 0; i < N_ITEMS; ++i)
+                queue.Push(Item{p, i});
+        }));
+
+    std::atomic_int popped{0};
+    std::vector<std::future<bool>> consumers;
+    consumers.reserve(N_CONSUMERS);
+    for (int c = 0; c < N_CONSUMERS; ++c)
+        consumers.emplace_back(std::async(std::launch::async, [&queue, &popped]() {
+            std::vector<int> last(N_PRODUCERS, -1);
+            while (popped.load(std::memory_order_relaxed) < N_PRODUCERS * N_ITEMS)
+            {
+                auto item = queue.TryPop();
+                if (!item)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                if (item->seq <= last[item->producer])
+                    return false;
+                last[item->producer] = item->seq;
+                popped.fetch_add(1, std::memory_order_relaxed);
+            }
+            return true;
+        }));
+
+    for (auto& producer : producers)
+        producer.get();
+
+    bool inOrder = true;
+    for (auto& consumer : consumers)
+        inOrder &= consumer.get();
+
+    std::cout << "popped " << popped << " of " << N_PRODUCERS * N_ITEMS << ", per producer order "
+              << (inOrder ? "kept" : "BROKEN") << ", empty " << queue.Empty() << '\n';
+
+    return inOrder && queue.Empty() ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "../../cpu.h"
+#include "epoch-reclamation.h"
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+// Source: M. Michael, M. Scott, Simple, Fast, and Practical Non-Blocking and Blocking Concurrent Queue Algorithms
+
+// Unbounded MPMC queue with the same API as ThreadSafeQueue.
+// Producers only CAS the tail, consumers only CAS the head, a thread that finds the tail lagging behind
+// swings it forward instead of waiting. Popped nodes are retired to an EpochDomain, so a thread that is
+// still reading one of them never sees it freed.
+template <typename T>
+class LockFreeQueue
+{
+public:
+    // Creates a dummy node that separates head/tail
+    explicit LockFreeQueue(EpochDomain& domain = DefaultEpochDomain()) : domain{domain}
+    {
+        auto* dummy = new Node;
+        head.store(dummy, std::memory_order_relaxed);
+        tail.store(dummy, std::memory_order_relaxed);
+    }
+
+    // No thread may use the queue anymore.
+    ~LockFreeQueue()
+    {
+        for (auto* node = head.load(std::memory_order_relaxed); node != nullptr;)
+            delete std::exchange(node, node->next.load(std::memory_order_relaxed));
+    }
+
+    LockFreeQueue(const LockFreeQueue&) = delete;
+    LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+    bool Empty()
+    {
+        EpochDomain::Guard guard{domain};
+        return head.load(std::memory_order_acquire)->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+    std::optional<T> TryPop()
+    {
+        EpochDomain::Guard guard{domain};
+        for (;;)
+        {
+            auto* oldHead = head.load(std::memory_order_acquire);
+            auto* next = oldHead->next.load(std::memory_order_acquire);
+            if (next == nullptr) // Head points to the dummy node, the list is empty
+                return std::nullopt;
+
+            // Never let head pass tail, or tail would point to a retired node.
+            auto* oldTail = tail.load(std::memory_order_acquire);
+            if (oldHead == oldTail)
+            {
+                tail.compare_exchange_weak(oldTail, next, std::memory_order_release, std::memory_order_relaxed);
+                continue;
+            }
+
+            if (head.compare_exchange_weak(oldHead, next, std::memory_order_acq_rel, std::memory_order_relaxed))
+            {
+                // next is the new dummy, only the winner of the CAS touches its data.
+                std::optional<T> res{std::move(next->data)};
+                next->data.reset();
+                domain.Retire(oldHead);
+                return res;
+            }
+        }
+    }
+
+    void Push(T data)
+    {
+        auto* node = new Node{std::move(data)};
+
+        EpochDomain::Guard guard{domain};
+        for (;;)
+        {
+            auto* oldTail = tail.load(std::memory_order_acquire);
+            auto* next = oldTail->next.load(std::memory_order_acquire);
+            if (next != nullptr)
+            {
+                // Another producer linked its node but hasn't swung the tail yet, help it.
+                tail.compare_exchange_weak(oldTail, next, std::memory_order_release, std::memory_order_relaxed);
+                continue;
+            }
+
+            if (oldTail->next.compare_exchange_weak(next, node, std::memory_order_release, std::memory_order_relaxed))
+            {
+                tail.compare_exchange_strong(oldTail, node, std::memory_order_release, std::memory_order_relaxed);
+                return;
+            }
+        }
+    }
+
+private:
+    struct Node
+    {
+        Node() = default;
+
+        explicit Node(T data) : data{std::move(data)}
+        {
+        }
+
+        std::optional<T> data;
+        std::atomic<Node*> next{nullptr};
+    };
+
+    EpochDomain& domain;
+    alignas(kNoSharing) std::atomic<Node*> head;
+    alignas(kNoSharing) std::atomic<Node*> tail;
+};
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "../../cpu.h"
+
+// Per-thread records of a reclamation domain (EpochDomain, HazardPointerDomain).
+// - Records live in a list that only grows until the registry is destroyed, so scanners walk it without locks.
+// - A thread keeps the records it took per registry and hands them back at exit by clearing owned, the next
+//   thread that needs a record takes one over with its contents. A registry destroyed first is skipped.
+// Record needs a std::atomic_bool owned{true} and a Record* next.
+template <typename Record>
+class ThreadRecordRegistry
+{
+public:
+    ThreadRecordRegistry() : id{nextId.fetch_add(1, std::memory_order_relaxed)}
+    {
+        std::lock_guard<std::mutex> lk{RegistryMutex()};
+        LiveRegistries().insert(id);
+    }
+
+    // No thread may use the registry anymore, deletes all records.
+    ~ThreadRecordRegistry()
+    {
+        {
+            std::lock_guard<std::mutex> lk{RegistryMutex()};
+            LiveRegistries().erase(id);
+        }
+
+        for (auto* record = Head(); record != nullptr;)
+            delete std::exchange(record, record->next);
+    }
+
+    ThreadRecordRegistry(const ThreadRecordRegistry&) = delete;
+    ThreadRecordRegistry& operator=(const ThreadRecordRegistry&) = delete;
+
+    // The first record of the calling thread.
+    Record& Local()
+    {
+        return Local([](const Record&) { return true; });
+    }
+
+    // A record of the calling thread for which usable(record) holds, takes another record if there is none.
+    template <typename Predicate>
+    Record& Local(Predicate usable)
+    {
+        auto& local = LocalRecords();
+        for (auto [registryId, record] : local.entries)
+            if (registryId == id && usable(*record))
+                return *record;
+
+        auto* record = AcquireRecord();
+        local.entries.emplace_back(id, record);
+        return *record;
+    }
+
+    // Start of the record list, records are never unlinked while the registry lives.
+    Record* Head() const
+    {
+        return records.load(std::memory_order_acquire);
+    }
+
+    std::size_t Size() const
+    {
+        return recordCount.load(std::memory_order_relaxed);
+    }
+
+private:
+    // Records of the registries the current thread has used, released at thread exit.
+    struct ThreadRecords
+    {
+        ~ThreadRecords()
+        {
+            std::lock_guard<std::mutex> lk{RegistryMutex()};
+            for (auto [registryId, record] : entries)
+                if (LiveRegistries().contains(registryId))
+                    record->owned.store(false, std::memory_order_release);
+        }
+
+        std::vector<std::pair<std::uint64_t, Record*>> entries;
+    };
+
+    static ThreadRecords& LocalRecords()
+    {
+        thread_local ThreadRecords local;
+        return local;
+    }
+
+    Record* AcquireRecord()
+    {
+        for (auto* record = Head(); record != nullptr; record = record->next)
+        {
+            bool owned = false;
+            if (record->owned.compare_exchange_strong(owned, true, std::memory_order_acquire))
+                return record;
+        }
+
+        auto* record = new Record;
+        record->next = records.load(std::memory_order_relaxed);
+        while (!records.compare_exchange_weak(record->next, record, std::memory_order_release,
+                                              std::memory_order_relaxed))
+            ;
+        recordCount.fetch_add(1, std::memory_order_relaxed);
+        return record;
+    }
+
+    static std::mutex& RegistryMutex()
+    {
+        static std::mutex mut;
+        return mut;
+    }
+
+    static std::unordered_set<std::uint64_t>& LiveRegistries()
+    {
+        static std::unordered_set<std::uint64_t> registries;
+        return registries;
+    }
+
+    static inline std::atomic_uint64_t nextId{0};
+
+    const std::uint64_t id;
+    alignas(kNoSharing) std::atomic<Record*> records{nullptr};
+    std::atomic_size_t recordCount{0};
+};
@@ -0,0 +1,474 @@
+#include "../cpu.h"
+#include "../thread-pool.h"
+#include "lock-based/lock-based-bounded-queue.h"
+#include "lock-based/lock-based-queue.h"
+#include "lock-based/sharded-queue.h"
+#include "lock-free/lock-free-bounded-queue.h"
+#include "lock-free/lock-free-queue.h"
+
+#include "bqueue.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <latch>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+
+// Throughput and enqueue-to-dequeue latency of every queue in the repo, swept over producer and consumer
+// counts, payload sizes and capacities. Prints one JSON document to stdout.
+// Usage: queue-bench [items per run] [max producers/consumers, default 2 x hardware threads]
+// Build with optimizations, e.g. -DCMAKE_BUILD_TYPE=Release.
+
+// Time stamp counter ticks, steady_clock nanoseconds where there's no TSC.
+std::uint64_t Ticks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+double TicksPerNs()
+{
+    const auto wallStart = std::chrono::steady_clock::now();
+    const auto ticksStart = Ticks();
+    std::this_thread::sleep_for(50ms);
+    const auto ticks = Ticks() - ticksStart;
+    const auto wall = std::chrono::duration<double, std::nano>{std::chrono::steady_clock::now() - wallStart};
+    return static_cast<double>(ticks) / wall.count();
+}
+
+// The producer's time stamp travels inside the payload.
+template <std::size_t Size>
+struct Payload
+{
+    static_assert(Size >= sizeof(std::uint64_t));
+
+    std::uint64_t stamp = 0;
+    std::array<std::byte, Size - sizeof(std::uint64_t)> pad{};
+};
+
+// Adapters give every queue the same blocking interface:
+// - Push(id, stamp) waits for room
+// - Pop(stamp) waits for an item, returns false once the queue is closed and drained
+// - Close() is called after all producers are done
+template <std::size_t PayloadSize>
+class LockBasedBoundedAdapter
+{
+public:
+    static constexpr std::string_view kName = "LockBasedBoundedQueue";
+    static constexpr bool kBounded = true;
+
+    explicit LockBasedBoundedAdapter(std::size_t capacity, std::size_t) : queue{capacity}
+    {
+    }
+
+    void Push(std::uint64_t, std::uint64_t stamp)
+    {
+        queue.WaitAndEmplace(Payload<PayloadSize>{stamp});
+    }
+
+    bool Pop(std::uint64_t& stamp)
+    {
+        auto val = queue.WaitAndPop();
+        if (val)
+            stamp = val->stamp;
+        return val.has_value();
+    }
+
+    void Close()
+    {
+        queue.Close();
+    }
+
+private:
+    LockBasedBoundedQueue<Payload<PayloadSize>> queue;
+};
+
+template <std::size_t PayloadSize>
+class LockFreeBoundedAdapter
+{
+public:
+    static constexpr std::string_view kName = "LockFreeBoundedQueue";
+    static constexpr bool kBounded = true;
+
+    explicit LockFreeBoundedAdapter(std::size_t capacity, std::size_t) : queue{capacity}
+    {
+    }
+
+    void Push(std::uint64_t, std::uint64_t stamp)
+    {
+        queue.WaitAndEmplace(Payload<PayloadSize>{stamp});
+    }
+
+    bool Pop(std::uint64_t& stamp)
+    {
+        auto val = queue.WaitAndPop();
+        if (val)
+            stamp = val->stamp;
+        return val.has_value();
+    }
+
+    void Close()
+    {
+        queue.Close();
+    }
+
+private:
+    LockFreeBoundedQueue<Payload<PayloadSize>> queue;
+};
+
+template <std::size_t PayloadSize>
+class ShardedAdapter
+{
+public:
+    static constexpr std::string_view kName = "ShardedQueue";
+    static constexpr bool kBounded = false;
+
+    explicit ShardedAdapter(std::size_t, std::size_t)
+    {
+    }
+
+    void Push(std::uint64_t, std::uint64_t stamp)
+    {
+        queue.Push(Payload<PayloadSize>{stamp});
+    }
+
+    bool Pop(std::uint64_t& stamp)
+    {
+        auto val = queue.WaitAndPop();
+        if (val)
+            stamp = val->stamp;
+        return val.has_value();
+    }
+
+    void Close()
+    {
+        queue.Close();
+    }
+
+private:
+    ShardedQueue<Payload<PayloadSize>> queue;
+};
+
+// Unbounded queues only have TryPop, consumers poll until the queue is closed and drained.
+template <typename Queue, std::size_t PayloadSize>
+class PollingAdapter
+{
+public:
+    static constexpr bool kBounded = false;
+
+    explicit PollingAdapter(std::size_t, std::size_t)
+    {
+    }
+
+    bool Pop(std::uint64_t& stamp)
+    {
+        for (;;)
+        {
+            if (TryPop(stamp))
+                return true;
+            // Every push happened before Close(), one more try drains them.
+            if (closed.load(std::memory_order_acquire))
+                return TryPop(stamp);
+            std::this_thread::yield();
+        }
+    }
+
+    void Close()
+    {
+        closed.store(true, std::memory_order_release);
+    }
+
+protected:
+    bool TryPop(std::uint64_t& stamp)
+    {
+        if constexpr (requires { queue.TryPop().has_value(); })
+        {
+            auto val = queue.TryPop();
+            if (val)
+                stamp = val->stamp;
+            return val.has_value();
+        }
+        else
+        {
+            Payload<PayloadSize> val;
+            if (!queue.TryPop(val))
+                return false;
+            stamp = val.stamp;
+            return true;
+        }
+    }
+
+    Queue queue;
+    std::atomic_bool closed{false};
+};
+
+template <std::size_t PayloadSize>
+class ThreadSafeAdapter : public PollingAdapter<ThreadSafeQueue<Payload<PayloadSize>>, PayloadSize>
+{
+public:
+    static constexpr std::string_view kName = "ThreadSafeQueue";
+
+    using PollingAdapter<ThreadSafeQueue<Payload<PayloadSize>>, PayloadSize>::PollingAdapter;
+
+    void Push(std::uint64_t, std::uint64_t stamp)
+    {
+        this->queue.Push(Payload<PayloadSize>{stamp});
+    }
+};
+
+template <std::size_t PayloadSize>
+class LockFreeAdapter : public PollingAdapter<LockFreeQueue<Payload<PayloadSize>>, PayloadSize>
+{
+public:
+    static constexpr std::string_view kName = "LockFreeQueue";
+
+    using PollingAdapter<LockFreeQueue<Payload<PayloadSize>>, PayloadSize>::PollingAdapter;
+
+    void Push(std::uint64_t, std::uint64_t stamp)
+    {
+        this->queue.Push(Payload<PayloadSize>{stamp});
+    }
+};
+
+// The queue ThreadPool uses for its shared (per node) queue.
+template <std::size_t PayloadSize>
+class PriorityLaneAdapter : public PollingAdapter<PriorityLaneQueue<Payload<PayloadSize>>, PayloadSize>
+{
+public:
+    static constexpr std::string_view kName = "PriorityLaneQueue";
+
+    using PollingAdapter<PriorityLaneQueue<Payload<PayloadSize>>, PayloadSize>::PollingAdapter;
+
+    void Push(std::uint64_t, std::uint64_t stamp)
+    {
+        this->queue.Push(Payload<PayloadSize>{stamp});
+    }
+};
+
+// BQueue carries an int, so it carries the item id and the stamps live in a side table. Every stamp has its
+// own cache line, or producers writing stamps would invalidate the line consumers are reading.
+class BQueueAdapter
+{
+public:
+    static constexpr std::string_view kName = "BQueue";
+    static constexpr bool kBounded = true;
+
+    BQueueAdapter(std::size_t capacity, std::size_t items) : queue{queue_init(capacity)}, stamps(items)
+    {
+        assert(items <= INT_MAX && "item ids must fit in an int");
+        if (!queue)
+            std::abort();
+    }
+
+    ~BQueueAdapter()
+    {
+        queue_destroy(queue);
+    }
+
+    BQueueAdapter(const BQueueAdapter&) = delete;
+    BQueueAdapter& operator=(const BQueueAdapter&) = delete;
+
+    void Push(std::uint64_t id, std::uint64_t stamp)
+    {
+        stamps[id].value = stamp;
+        queue_wait_push(queue, static_cast<int>(id));
+    }
+
+    bool Pop(std::uint64_t& stamp)
+    {
+        int id = 0;
+        if (!queue_wait_pop(queue, &id))
+            return false;
+        stamp = stamps[static_cast<std::size_t>(id)].value;
+        return true;
+    }
+
+    void Close()
+    {
+        queue_close(queue);
+    }
+
+private:
+    struct alignas(kNoSharing) Stamp
+    {
+        std::uint64_t value = 0;
+    };
+
+    BQueue* queue;
+    std::vector<Stamp> stamps;
+};
+
+struct Result
+{
+    std::string_view queue;
+    std::size_t producers = 0;
+    std::size_t consumers = 0;
+    std::size_t payload = 0;
+    std::optional<std::size_t> capacity;
+    double opsPerSec = 0;
+    double p50Ns = 0;
+    double p99Ns = 0;
+    double p999Ns = 0;
+};
+
+template <typename Adapter>
+Result Run(std::size_t producers, std::size_t consumers, std::size_t payload, std::size_t capacity,
+           std::size_t items, double ticksPerNs)
+{
+    const auto perProducer = items / producers;
+    const auto total = perProducer * producers;
+
+    Adapter queue{capacity, total};
+    std::vector<std::vector<std::uint64_t>> latencies(consumers);
+    std::latch ready{static_cast<std::ptrdiff_t>(producers + consumers + 1)};
+
+    std::vector<std::thread> producerThreads;
+    for (std::size_t p = 0; p < producers; ++p)
+        producerThreads.emplace_back([&, p]() {
+            ready.arrive_and_wait();
+            for (std::size_t i = 0; i < perProducer; ++i)
+                queue.Push(p * perProducer + i, Ticks());
+        });
+
+    std::vector<std::thread> consumerThreads;
+    for (std::size_t c = 0; c < consumers; ++c)
+        consumerThreads.emplace_back([&, c]() {
+            auto& samples = latencies[c];
+            samples.reserve(total / consumers + 1);
+            ready.arrive_and_wait();
+            std::uint64_t stamp = 0;
+            while (queue.Pop(stamp))
+                samples.push_back(Ticks() - stamp);
+        });
+
+    ready.arrive_and_wait();
+    const auto start = std::chrono::steady_clock::now();
+    for (auto& thread : producerThreads)
+        thread.join();
+    queue.Close();
+    for (auto& thread : consumerThreads)
+        thread.join();
+    const auto elapsed = std::chrono::duration<double>{std::chrono::steady_clock::now() - start};
+
+    std::vector<std::uint64_t> all;
+    all.reserve(total);
+    for (const auto& samples : latencies)
+        all.insert(all.end(), samples.begin(), samples.end());
+
+    const auto percentile = [&](double p) {
+        if (all.empty())
+            return 0.0;
+        const auto nth = all.begin() + static_cast<std::ptrdiff_t>(p * static_cast<double>(all.size() - 1));
+        std::ranges::nth_element(all, nth);
+        return static_cast<double>(*nth) / ticksPerNs;
+    };
+
+    Result res;
+    res.queue = Adapter::kName;
+    res.producers = producers;
+    res.consumers = consumers;
+    res.payload = payload;
+    if (Adapter::kBounded)
+        res.capacity = capacity;
+    res.opsPerSec = static_cast<double>(all.size()) / elapsed.count();
+    res.p50Ns = percentile(0.5);
+    res.p99Ns = percentile(0.99);
+    res.p999Ns = percentile(0.999);
+    return res;
+}
+
+struct Sweep
+{
+    std::vector<std::size_t> threadCounts;
+    std::vector<std::size_t> capacities;
+    std::size_t items = 0;
+    double ticksPerNs = 1;
+    std::vector<Result> results;
+
+    template <typename Adapter>
+    void Add(std::size_t payload)
+    {
+        for (const auto producers : threadCounts)
+            for (const auto consumers : threadCounts)
+            {
+                if (!Adapter::kBounded)
+                {
+                    results.push_back(Run<Adapter>(producers, consumers, payload, 0, items, ticksPerNs));
+                    continue;
+                }
+
+                for (const auto capacity : capacities)
+                    results.push_back(Run<Adapter>(producers, consumers, payload, capacity, items, ticksPerNs));
+            }
+    }
+
+    template <std::size_t PayloadSize>
+    void AddPayload()
+    {
+        Add<LockBasedBoundedAdapter<PayloadSize>>(PayloadSize);
+        Add<LockFreeBoundedAdapter<PayloadSize>>(PayloadSize);
+        Add<ThreadSafeAdapter<PayloadSize>>(PayloadSize);
+        Add<LockFreeAdapter<PayloadSize>>(PayloadSize);
+        Add<PriorityLaneAdapter<PayloadSize>>(PayloadSize);
+        Add<ShardedAdapter<PayloadSize>>(PayloadSize);
+    }
+};
+
+void PrintJson(const Sweep& sweep)
+{
+    std::cout << "{\n  \"ticks_per_ns\": " << sweep.ticksPerNs << ",\n  \"items\": " << sweep.items
+              << ",\n  \"results\": [\n";
+    for (std::size_t i = 0; i < sweep.results.size(); ++i)
+    {
+        const auto& res = sweep.results[i];
+        std::cout << "    {\"queue\": \"" << res.queue << "\", \"producers\": " << res.producers
+                  << ", \"consumers\": " << res.consumers << ", \"payload_bytes\": " << res.payload
+                  << ", \"capacity\": " << (res.capacity ? std::to_string(*res.capacity) : "null"s)
+                  << ", \"ops_per_sec\": " << static_cast<std::uint64_t>(res.opsPerSec)
+                  << ", \"p50_ns\": " << res.p50Ns << ", \"p99_ns\": " << res.p99Ns << ", \"p999_ns\": " << res.p999Ns
+                  << '}' << (i + 1 < sweep.results.size() ? "," : "") << '\n';
+    }
+    std::cout << "  ]\n}\n";
+}
+
+int main(int argc, char* argv[])
+{
+    Sweep sweep;
+    sweep.items = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200'000;
+    const std::size_t maxThreads = argc > 2 ? std::strtoull(argv[2], nullptr, 10)
+                                            : 2 * std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t n = 1; n <= maxThreads; n *= 2)
+        sweep.threadCounts.push_back(n);
+    sweep.capacities = {64, 1024};
+    sweep.ticksPerNs = TicksPerNs();
+
+    sweep.Add<BQueueAdapter>(sizeof(int));
+    sweep.AddPayload<8>();
+    sweep.AddPayload<64>();
+    sweep.AddPayload<256>();
+
+    PrintJson(sweep);
+
+    return 0;
+}
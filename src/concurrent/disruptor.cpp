@@ -0,0 +1,88 @@
+#include "disruptor.h"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// A decode -> enrich -> persist pipeline working on the same ring slots.
+struct Event
+{
+    std::int64_t raw = 0;
+    std::int64_t decoded = 0;
+    std::int64_t enriched = 0;
+};
+
+template <ProducerType Producers, typename WaitStrategy>
+void RunPipeline(std::string_view name, int producerCount)
+{
+    constexpr std::int64_t kEvents = 1'000'000;
+    using Ring = Disruptor<Event, 1024, Producers, WaitStrategy>;
+
+    Ring ring;
+
+    BatchEventProcessor decode{ring, {}, [](Event& event, std::int64_t, bool) { event.decoded = event.raw * 2; }};
+    BatchEventProcessor enrich{ring,
+                               {&decode.GetSequence()},
+                               [](Event& event, std::int64_t, bool) { event.enriched = event.decoded + 1; }};
+
+    std::int64_t persisted = 0;
+    std::int64_t checksum = 0;
+    std::int64_t batches = 0;
+    BatchEventProcessor persist{ring, {&enrich.GetSequence()}, [&](Event& event, std::int64_t, bool endOfBatch) {
+                                    ++persisted;
+                                    checksum += event.enriched;
+                                    batches += endOfBatch;
+                                }};
+    ring.AddGatingSequence(persist.GetSequence());
+
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> stages;
+    stages.emplace_back([&]() { decode.Run(); });
+    stages.emplace_back([&]() { enrich.Run(); });
+    stages.emplace_back([&]() { persist.Run(); });
+
+    std::vector<std::thread> producers;
+    const auto perProducer = kEvents / producerCount;
+    for (int p = 0; p < producerCount; ++p)
+        producers.emplace_back([&]() {
+            for (std::int64_t i = 0; i < perProducer; ++i)
+                ring.PublishEvent([](Event& event, std::int64_t seq) { event.raw = seq; });
+        });
+
+    for (auto& producer : producers)
+        producer.join();
+
+    const auto last = perProducer * producerCount - 1;
+    while (persist.GetSequence().Load() < last)
+        std::this_thread::yield();
+    const auto elapsed = std::chrono::duration<double>{std::chrono::steady_clock::now() - start};
+
+    decode.Halt();
+    enrich.Halt();
+    persist.Halt();
+    for (auto& stage : stages)
+        stage.join();
+
+    // Every event went through decode and enrich before persist saw it: sum of (2 * seq + 1).
+    const auto expected = (last + 1) * (last + 1);
+    std::cout << name << ": " << persisted << " events in " << batches << " batches, checksum "
+              << (checksum == expected ? "ok" : "WRONG") << ", "
+              << static_cast<double>(persisted) / elapsed.count() / 1e6 << " M events/s\n";
+}
+
+int main()
+{
+    RunPipeline<ProducerType::Single, BlockingWait>("1 producer, blocking", 1);
+    RunPipeline<ProducerType::Single, YieldingWait>("1 producer, yielding", 1);
+    RunPipeline<ProducerType::Multi, BlockingWait>("3 producers, blocking", 3);
+    RunPipeline<ProducerType::Multi, YieldingWait>("3 producers, yielding", 3);
+    // Busy spinning needs a core per stage.
+    if (std::thread::hardware_concurrency() >= 4)
+        RunPipeline<ProducerType::Single, BusySpinWait>("1 producer, busy spin", 1);
+
+    return 0;
+}
@@ -0,0 +1,365 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "cpu.h"
+
+// Source: https://lmax-exchange.github.io/disruptor/disruptor.html
+
+// Disruptor: a preallocated ring of events shared by producers and a pipeline of consumer stages.
+// - Producers claim sequence numbers from a sequencer, fill the events in place and publish them.
+// - Every stage tracks its progress in a Sequence and waits on a barrier: the published cursor for the first
+//   stage, the Sequences of the stages it depends on for the others. All stages work on the same slot, nothing
+//   is copied between hops.
+// - A stage that falls behind catches up in one batch: it processes everything up to the highest available
+//   sequence and publishes its progress once.
+// - The last stages gate the producers, a slot is reused only after all of them are done with it.
+
+// A padded sequence number, -1 means nothing processed/published yet.
+struct alignas(kNoSharing) Sequence
+{
+    std::int64_t Load() const
+    {
+        return value.load(std::memory_order_acquire);
+    }
+
+    void Store(std::int64_t seq)
+    {
+        value.store(seq, std::memory_order_release);
+    }
+
+    std::atomic<std::int64_t> value{-1};
+};
+
+// Wait strategies: Wait(ready) returns once ready() is true, Signal() is called after every sequence update.
+
+// Lowest latency, burns a core per waiting stage.
+struct BusySpinWait
+{
+    template <typename Ready>
+    void Wait(Ready ready)
+    {
+        while (!ready())
+            CpuRelax();
+    }
+
+    void Signal()
+    {
+    }
+};
+
+// Spins a little, then gives the core away between checks.
+struct YieldingWait
+{
+    static constexpr int kSpinCount = 100;
+
+    template <typename Ready>
+    void Wait(Ready ready)
+    {
+        for (int spins = 0; !ready(); ++spins)
+        {
+            if (spins < kSpinCount)
+                CpuRelax();
+            else
+                std::this_thread::yield();
+        }
+    }
+
+    void Signal()
+    {
+    }
+};
+
+// Sleeps on an eventcount, Signal() only makes a syscall when somebody sleeps.
+class BlockingWait
+{
+public:
+    template <typename Ready>
+    void Wait(Ready ready)
+    {
+        while (!ready())
+        {
+            const auto current = epoch.load(std::memory_order_acquire);
+            waiters.fetch_add(1, std::memory_order_relaxed);
+            // Order matters: either we see the new sequence or the signaler sees us waiting.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!ready())
+                epoch.wait(current, std::memory_order_acquire);
+            waiters.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    void Signal()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters.load(std::memory_order_relaxed) == 0)
+            return;
+
+        epoch.fetch_add(1, std::memory_order_release);
+        epoch.notify_all();
+    }
+
+private:
+    alignas(kNoSharing) std::atomic_uint32_t epoch{0};
+    std::atomic_uint32_t waiters{0};
+};
+
+enum class ProducerType
+{
+    Single, // claiming is a plain increment
+    Multi,  // claiming is a fetch_add, every slot carries its published sequence
+};
+
+template <typename Event, std::size_t Size, ProducerType Producers = ProducerType::Single,
+          typename WaitStrategy = BlockingWait>
+class Disruptor
+{
+    static_assert(Size >= 2 && std::has_single_bit(Size), "Size must be a power of two");
+
+public:
+    class Barrier;
+
+    Disruptor() : events(Size)
+    {
+        if constexpr (Producers == ProducerType::Multi)
+        {
+            published = std::make_unique<std::atomic<std::int64_t>[]>(Size);
+            for (std::size_t i = 0; i < Size; ++i)
+                published[i].store(-1, std::memory_order_relaxed);
+        }
+    }
+
+    Disruptor(const Disruptor&) = delete;
+    Disruptor& operator=(const Disruptor&) = delete;
+
+    Event& operator[](std::int64_t seq)
+    {
+        return events[static_cast<std::size_t>(seq) & kMask];
+    }
+
+    // The stages whose progress frees slots for the producers, set before producing starts.
+    void AddGatingSequence(const Sequence& sequence)
+    {
+        gating.push_back(&sequence);
+    }
+
+    // Claims n slots and returns the highest claimed sequence, the first one is the result - n + 1.
+    // Waits while the ring is full.
+    std::int64_t Claim(std::int64_t n = 1)
+    {
+        std::int64_t hi = 0;
+        if constexpr (Producers == ProducerType::Single)
+            hi = nextToClaim += n;
+        else
+            hi = claimed.value.fetch_add(n, std::memory_order_relaxed) + n;
+
+        // Only the producer that wraps past the slowest stage waits, the cached minimum avoids scanning
+        // the gating sequences on every claim.
+        const auto wrapPoint = hi - static_cast<std::int64_t>(Size);
+        if (wrapPoint > cachedGatingMin.load(std::memory_order_relaxed))
+        {
+            std::int64_t gatingMin = 0;
+            for (int spins = 0; wrapPoint > (gatingMin = MinGating()); ++spins)
+            {
+                if (spins < YieldingWait::kSpinCount)
+                    CpuRelax();
+                else
+                    std::this_thread::yield();
+            }
+            cachedGatingMin.store(gatingMin, std::memory_order_relaxed);
+        }
+
+        return hi;
+    }
+
+    // Makes the claimed sequences lo..hi visible to the first stages.
+    void Publish(std::int64_t lo, std::int64_t hi)
+    {
+        if constexpr (Producers == ProducerType::Single)
+        {
+            cursor.Store(hi);
+        }
+        else
+        {
+            for (auto seq = lo; seq <= hi; ++seq)
+                published[static_cast<std::size_t>(seq) & kMask].store(seq, std::memory_order_release);
+        }
+
+        waitStrategy.Signal();
+    }
+
+    void Publish(std::int64_t seq)
+    {
+        Publish(seq, seq);
+    }
+
+    // Claims one slot, fills it in place and publishes it.
+    template <typename Fill>
+    void PublishEvent(Fill fill)
+    {
+        const auto seq = Claim();
+        fill((*this)[seq], seq);
+        Publish(seq);
+    }
+
+    // Barrier of a stage, waits for the producers if there are no dependencies, otherwise for all the stages it
+    // depends on.
+    Barrier NewBarrier(std::vector<const Sequence*> dependencies = {})
+    {
+        return Barrier{*this, std::move(dependencies)};
+    }
+
+    class Barrier
+    {
+    public:
+        static constexpr std::int64_t kAlerted = -2;
+
+        // Returns the highest available sequence >= next, waits if there's none, or kAlerted after Alert().
+        std::int64_t WaitFor(std::int64_t next)
+        {
+            std::int64_t available = -1;
+            disruptor->waitStrategy.Wait([&]() {
+                if (alerted.load(std::memory_order_acquire))
+                    return true;
+                available = Available(next);
+                return available >= next;
+            });
+
+            return alerted.load(std::memory_order_acquire) ? kAlerted : available;
+        }
+
+        // Wakes the stage up and makes its WaitFor() calls fail, used for shutdown.
+        void Alert()
+        {
+            alerted.store(true, std::memory_order_release);
+            disruptor->waitStrategy.Signal();
+        }
+
+        void Signal()
+        {
+            disruptor->waitStrategy.Signal();
+        }
+
+    private:
+        friend class Disruptor;
+
+        Barrier(Disruptor& disruptor, std::vector<const Sequence*> dependencies)
+            : disruptor{&disruptor}, dependencies{std::move(dependencies)}
+        {
+        }
+
+        std::int64_t Available(std::int64_t next) const
+        {
+            if (!dependencies.empty())
+            {
+                // Upstream stages only ever see published events.
+                auto min = std::numeric_limits<std::int64_t>::max();
+                for (const auto* dependency : dependencies)
+                    min = std::min(min, dependency->Load());
+                return min;
+            }
+
+            if constexpr (Producers == ProducerType::Single)
+            {
+                return disruptor->cursor.Load();
+            }
+            else
+            {
+                // Claimed slots may be published out of order, stop at the first gap.
+                const auto claimed = disruptor->claimed.Load();
+                auto seq = next;
+                while (seq <= claimed &&
+                       disruptor->published[static_cast<std::size_t>(seq) & kMask].load(std::memory_order_acquire) ==
+                           seq)
+                    ++seq;
+                return seq - 1;
+            }
+        }
+
+        Disruptor* disruptor;
+        std::vector<const Sequence*> dependencies;
+        std::atomic_bool alerted{false};
+    };
+
+private:
+    static constexpr std::size_t kMask = Size - 1;
+
+    std::int64_t MinGating() const
+    {
+        auto min = Producers == ProducerType::Single ? nextToClaim : claimed.Load();
+        for (const auto* sequence : gating)
+            min = std::min(min, sequence->Load());
+        return min;
+    }
+
+    std::vector<Event> events;
+    std::vector<const Sequence*> gating;
+    WaitStrategy waitStrategy;
+
+    // Single producer: the producer's next claim (only producer can access) and the published cursor.
+    alignas(kNoSharing) std::int64_t nextToClaim = -1;
+    Sequence cursor;
+    // Multi producer: the highest claimed sequence and the published sequence of every slot.
+    Sequence claimed;
+    std::unique_ptr<std::atomic<std::int64_t>[]> published;
+    alignas(kNoSharing) std::atomic<std::int64_t> cachedGatingMin{-1};
+};
+
+// Runs a stage on its own thread: handler(event, seq, endOfBatch) for every available event, then publishes
+// the stage's progress once per batch.
+template <typename DisruptorType, typename Handler>
+class BatchEventProcessor
+{
+public:
+    using Barrier = typename DisruptorType::Barrier;
+
+    // Without dependencies the stage waits for the producers, otherwise for the given upstream stages.
+    BatchEventProcessor(DisruptorType& disruptor, std::vector<const Sequence*> dependencies, Handler handler)
+        : disruptor{disruptor}, barrier{disruptor.NewBarrier(std::move(dependencies))}, handler{std::move(handler)}
+    {
+    }
+
+    const Sequence& GetSequence() const
+    {
+        return sequence;
+    }
+
+    // Returns after Halt().
+    void Run()
+    {
+        auto next = sequence.Load() + 1;
+        for (;;)
+        {
+            const auto available = barrier.WaitFor(next);
+            if (available == Barrier::kAlerted)
+                return;
+
+            for (; next <= available; ++next)
+                handler(disruptor[next], next, next == available);
+
+            sequence.Store(available);
+            // Wakes the stages waiting for us.
+            barrier.Signal();
+        }
+    }
+
+    void Halt()
+    {
+        barrier.Alert();
+    }
+
+private:
+    DisruptorType& disruptor;
+    Barrier barrier;
+    Handler handler;
+    Sequence sequence;
+};
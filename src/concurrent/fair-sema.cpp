@@ -0,0 +1,64 @@
+#include "fair-sema.h"
+
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+int main()
+{
+    constexpr int kThreads = 5;
+
+    FairSemaphore sema{0};
+    std::mutex orderMtx;
+    std::vector<int> order;
+
+    // Thread i starts only once thread i - 1 holds its ticket, so ticket order is thread order and the permits
+    // must reach the threads in the same order.
+    std::vector<std::thread> threads;
+    threads.reserve(kThreads);
+    for (int i = 0; i < kThreads; ++i)
+    {
+        threads.emplace_back([&, i]() {
+            sema.Wait();
+            {
+                std::lock_guard<std::mutex> lk{orderMtx};
+                order.push_back(i);
+            }
+            std::cout << "thread " << i << " entered the critical region" << std::endl;
+            sema.Post();
+        });
+        while (sema.Waiting() != static_cast<std::uint64_t>(i) + 1)
+            std::this_thread::yield();
+    }
+
+    int failures = 0;
+
+    // A barging Wait() would get this permit before the queued threads.
+    if (sema.TryWait())
+    {
+        std::cerr << "TryWait took a permit ahead of the waiting threads\n";
+        ++failures;
+    }
+
+    sema.Post();
+    for (auto& t : threads)
+        t.join();
+
+    for (int i = 0; i < kThreads; ++i)
+        if (order[i] != i)
+        {
+            std::cerr << "permit " << i << " went to thread " << order[i] << '\n';
+            ++failures;
+        }
+
+    // The permit the last thread posted is free again.
+    if (!sema.TryWait())
+    {
+        std::cerr << "the permit posted by the last thread isn't free\n";
+        ++failures;
+    }
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+
+#include "cpu.h"
+
+// FIFO-fair counting semaphore: permits are handed out in ticket order.
+// - Wait() draws a ticket, the ticket is served once the number of permits ever posted passes it. A thread
+//   that posts and waits again gets a new ticket behind everybody already waiting, it can't barge in.
+// - Every waiter sleeps on the futex word of its ticket's slot, Post(n) wakes exactly the n waiters whose
+//   tickets it serves and makes no syscall for waiters that haven't gone to sleep.
+// - Tickets kSlots apart share a slot, with more than kSlots sleeping waiters a wake-up can be spurious.
+class FairSemaphore
+{
+public:
+    explicit FairSemaphore(std::uint32_t count = 0) : served{count}
+    {
+    }
+
+    FairSemaphore(const FairSemaphore&) = delete;
+    FairSemaphore& operator=(const FairSemaphore&) = delete;
+
+    void Post(std::uint32_t n = 1)
+    {
+        const auto first = served.fetch_add(n, std::memory_order_seq_cst);
+        // Only tickets drawn already can have a waiter, later ones see the new count and don't sleep.
+        const auto last = std::min(first + n, nextTicket.load(std::memory_order_seq_cst));
+        for (auto ticket = first; ticket < last; ++ticket)
+        {
+            auto& slot = slots[ticket % kSlots];
+            slot.generation.fetch_add(1, std::memory_order_seq_cst);
+            // Order matters: either the waiter sees its ticket served or we see it sleeping.
+            if (slot.sleepers.load(std::memory_order_seq_cst) != 0)
+                FutexWakeAll(slot.generation);
+        }
+    }
+
+    // Succeeds only if a permit is free and nobody is waiting for one.
+    bool TryWait()
+    {
+        auto ticket = nextTicket.load(std::memory_order_seq_cst);
+        while (ticket < served.load(std::memory_order_seq_cst))
+            if (nextTicket.compare_exchange_weak(ticket, ticket + 1, std::memory_order_seq_cst))
+                return true;
+        return false;
+    }
+
+    void Wait()
+    {
+        const auto ticket = nextTicket.fetch_add(1, std::memory_order_seq_cst);
+        auto& slot = slots[ticket % kSlots];
+        for (;;)
+        {
+            // Read the generation first, a Post() after this changes it and the futex wait returns at once.
+            const auto generation = slot.generation.load(std::memory_order_seq_cst);
+            if (Served(ticket))
+                return;
+
+            slot.sleepers.fetch_add(1, std::memory_order_seq_cst);
+            if (!Served(ticket))
+                FutexWait(slot.generation, generation);
+            slot.sleepers.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Number of threads that drew a ticket and aren't served yet, a snapshot.
+    [[nodiscard]] std::uint64_t Waiting() const
+    {
+        const auto drawn = nextTicket.load(std::memory_order_seq_cst);
+        const auto permits = served.load(std::memory_order_seq_cst);
+        return drawn > permits ? drawn - permits : 0;
+    }
+
+private:
+    static constexpr std::size_t kSlots = 128;
+
+    // Futex word of the waiters whose ticket maps here, bumped whenever one of them is served.
+    struct alignas(kNoSharing) Slot
+    {
+        std::atomic_uint32_t generation{0};
+        std::atomic_uint32_t sleepers{0};
+    };
+
+    static_assert(sizeof(std::atomic_uint32_t) == sizeof(std::uint32_t), "the generation is used as a futex word");
+
+    bool Served(std::uint64_t ticket) const
+    {
+        return ticket < served.load(std::memory_order_seq_cst);
+    }
+
+    static void FutexWait(std::atomic_uint32_t& word, std::uint32_t expected)
+    {
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+    }
+
+    // Wakes everybody on the slot, with at most kSlots waiters that is exactly the one being served.
+    static void FutexWakeAll(std::atomic_uint32_t& word)
+    {
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+    }
+
+    // Tickets drawn and tickets served, a ticket below served holds a permit.
+    alignas(kNoSharing) std::atomic_uint64_t nextTicket{0};
+    alignas(kNoSharing) std::atomic_uint64_t served;
+    std::array<Slot, kSlots> slots{};
+};
@@ -0,0 +1,46 @@
+#include "futex-sema.h"
+
+#include <cassert>
+#include <iostream>
+#include <syncstream>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+
+int main()
+{
+    FutexSemaphore sema{0};
+
+    // Nobody posts, the timed wait must give up.
+    const auto start = std::chrono::steady_clock::now();
+    const auto acquired = sema.WaitFor(50ms);
+    assert(!acquired && std::chrono::steady_clock::now() - start >= 50ms);
+    std::cout << "WaitFor timed out after " << (std::chrono::steady_clock::now() - start) / 1ms << "ms\n";
+
+    const auto doWork = [&]() {
+        const auto tid = std::this_thread::get_id();
+        std::osyncstream{std::cout} << "thread " << tid << " waiting...\n";
+
+        sema.Wait();
+        std::osyncstream{std::cout} << "thread " << tid << " entered the critical region\n";
+        sema.Post();
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(5);
+    for (int i = 0; i < 5; ++i)
+        threads.emplace_back(doWork);
+
+    std::this_thread::sleep_for(1s);
+    sema.Post();
+
+    for (auto& t : threads)
+        t.join();
+
+    // The last thread posted once more.
+    const auto left = sema.WaitUntil(std::chrono::system_clock::now() + 1s);
+    assert(left && !sema.TryWait());
+
+    return acquired || !left ? 1 : 0;
+}
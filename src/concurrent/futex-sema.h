@@ -0,0 +1,132 @@
+#pragma once
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <thread>
+
+#include "cpu.h"
+
+// Source: U. Drepper, Futexes Are Tricky
+
+// Counting semaphore on a raw futex, the count itself is the futex word.
+// - Uncontended Wait() is one CAS on the count, uncontended Post() one fetch_add.
+// - Waiters register in a separate counter before they sleep, Post() only makes the FUTEX_WAKE syscall when
+//   somebody is registered.
+// - A blocking Wait() first spins for spinCount rounds, a Post() that comes soon after costs no sleep at all.
+class FutexSemaphore
+{
+public:
+    // Spinning only pays off when the poster can run on another core.
+    static unsigned DefaultSpinCount()
+    {
+        return std::thread::hardware_concurrency() > 1 ? 64 : 0;
+    }
+
+    explicit FutexSemaphore(std::uint32_t count = 0, unsigned spinCount = DefaultSpinCount())
+        : count{count}, spinCount{spinCount}
+    {
+    }
+
+    FutexSemaphore(const FutexSemaphore&) = delete;
+    FutexSemaphore& operator=(const FutexSemaphore&) = delete;
+
+    void Post(std::uint32_t n = 1)
+    {
+        count.fetch_add(n, std::memory_order_seq_cst);
+        // Order matters: either a waiter sees the new count or we see the waiter.
+        if (waiters.load(std::memory_order_seq_cst) != 0)
+            FutexWake(static_cast<int>(n));
+    }
+
+    bool TryWait()
+    {
+        auto current = count.load(std::memory_order_seq_cst);
+        while (current != 0)
+            if (count.compare_exchange_weak(current, current - 1, std::memory_order_acquire,
+                                            std::memory_order_relaxed))
+                return true;
+        return false;
+    }
+
+    void Wait()
+    {
+        if (Spin())
+            return;
+
+        waiters.fetch_add(1, std::memory_order_seq_cst);
+        while (!TryWait())
+            FutexWait(nullptr);
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Returns false if the count stayed 0 until the deadline.
+    template <typename Clock, typename Duration>
+    bool WaitUntil(const std::chrono::time_point<Clock, Duration>& deadline)
+    {
+        if (Spin())
+            return true;
+
+        // FUTEX_WAIT_BITSET takes an absolute CLOCK_MONOTONIC time, which is what steady_clock uses on Linux.
+        const auto steadyDeadline = std::chrono::steady_clock::now() + (deadline - Clock::now());
+        const auto sinceEpoch = steadyDeadline.time_since_epoch();
+        const auto secs = std::chrono::duration_cast<std::chrono::seconds>(sinceEpoch);
+        const auto nsecs = std::chrono::duration_cast<std::chrono::nanoseconds>(sinceEpoch - secs);
+        const timespec ts{static_cast<time_t>(secs.count()), static_cast<long>(nsecs.count())};
+
+        waiters.fetch_add(1, std::memory_order_seq_cst);
+        bool acquired = false;
+        while (!(acquired = TryWait()))
+            if (FutexWait(&ts) == ETIMEDOUT)
+            {
+                acquired = TryWait();
+                break;
+            }
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+
+        return acquired;
+    }
+
+    template <typename Rep, typename Period>
+    bool WaitFor(const std::chrono::duration<Rep, Period>& timeout)
+    {
+        return WaitUntil(std::chrono::steady_clock::now() + timeout);
+    }
+
+private:
+    static_assert(sizeof(std::atomic_uint32_t) == sizeof(std::uint32_t), "the count is used as a futex word");
+
+    bool Spin()
+    {
+        for (unsigned spins = 0; spins < spinCount; ++spins)
+        {
+            if (TryWait())
+                return true;
+            CpuRelax();
+        }
+        return TryWait();
+    }
+
+    // Sleeps while the count is 0, returns 0 or the errno of the syscall.
+    int FutexWait(const timespec* deadline)
+    {
+        const auto res = syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&count),
+                                 FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG, 0, deadline, nullptr, FUTEX_BITSET_MATCH_ANY);
+        return res == 0 ? 0 : errno;
+    }
+
+    void FutexWake(int n)
+    {
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&count), FUTEX_WAKE_PRIVATE, n, nullptr, nullptr, 0);
+    }
+
+    std::atomic_uint32_t count;
+    std::atomic_uint32_t waiters{0};
+    const unsigned spinCount;
+};
@@ -0,0 +1,58 @@
+#include "left-right.h"
+
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <iostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+int main()
+{
+    constexpr int kInitial = 100'000;
+    constexpr int kInserts = 10'000;
+    constexpr int kReaders = 4;
+
+    std::unordered_map<int, int> initial;
+    for (int key = 0; key < kInitial; ++key)
+        initial.emplace(key, key * 2);
+
+    // The writer only inserts, a reader must never see a table shrink or a wrong value.
+    LeftRight<std::unordered_map<int, int>> table{std::move(initial)};
+    std::atomic_bool done{false};
+
+    auto writer = std::async(std::launch::async, [&]() {
+        for (int key = kInitial; key < kInitial + kInserts; ++key)
+            table.Modify([key](auto& map) { map.emplace(key, key * 2); });
+        done.store(true, std::memory_order_release);
+    });
+
+    std::vector<std::future<std::size_t>> readers;
+    for (int r = 0; r < kReaders; ++r)
+        readers.push_back(std::async(std::launch::async, [&, r]() {
+            std::size_t lastSize = 0;
+            std::size_t reads = 0;
+            for (int key = r; !done.load(std::memory_order_acquire); key = (key + 7919) % (kInitial + kInserts))
+            {
+                const auto handle = table.Get();
+                if (handle->size() < lastSize)
+                    throw std::runtime_error("table shrank");
+                lastSize = handle->size();
+
+                if (const auto it = handle->find(key); it != handle->end() && it->second != key * 2)
+                    throw std::runtime_error("wrong value");
+                ++reads;
+            }
+            return reads;
+        }));
+
+    writer.get();
+    for (auto& reader : readers)
+        std::cout << "reader: " << reader.get() << " lookups\n";
+
+    const auto size = table.Read([](const auto& map) { return map.size(); });
+    std::cout << "final size " << size << '\n';
+
+    return size == kInitial + kInserts ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "cpu.h"
+
+// Source: P. Ramalhete, A. Correia, Left-Right: A Concurrency Control Technique with Wait-Free Population
+//         Oblivious Reads
+
+// Left-Right: two instances of T, readers use one while the writer mutates the other.
+// - A reader announces itself in a sharded read indicator, reads the active instance and leaves. No
+//   allocation, no retry, no waiting: reads are wait-free.
+// - A writer applies its change to the inactive instance, switches readers over, waits until nobody reads the
+//   old one anymore and applies the same change to it. Writers are serialized and wait for readers.
+// Publish copies the whole T into both instances. Only Modify avoids the copy, it applies the change twice,
+// so large tables should be updated through Modify.
+template <typename T>
+class LeftRight
+{
+    struct Shard;
+
+public:
+    // Keeps the reader registered while it lives, must not outlive the calling thread. Long-lived handles make
+    // writers wait.
+    class ReadHandle
+    {
+    public:
+        ~ReadHandle()
+        {
+            shard->readers[versionIndex].fetch_sub(1, std::memory_order_release);
+        }
+
+        ReadHandle(const ReadHandle&) = delete;
+        ReadHandle& operator=(const ReadHandle&) = delete;
+
+        const T& operator*() const
+        {
+            return *doc;
+        }
+
+        const T* operator->() const
+        {
+            return doc;
+        }
+
+    private:
+        friend class LeftRight;
+
+        explicit ReadHandle(const LeftRight& leftRight)
+            : shard{&leftRight.shards[leftRight.Home()]},
+              versionIndex{leftRight.versionIndex.load(std::memory_order_seq_cst)}
+        {
+            // Order matters: the writer must see us in the indicator before we pick the instance to read.
+            shard->readers[versionIndex].fetch_add(1, std::memory_order_seq_cst);
+            doc = &leftRight.instances[leftRight.activeInstance.load(std::memory_order_seq_cst)];
+        }
+
+        Shard* shard;
+        std::uint32_t versionIndex;
+        const T* doc = nullptr;
+    };
+
+    explicit LeftRight(T initial = T{}, std::size_t readerShards = std::max(1u, std::thread::hardware_concurrency()))
+        : instances{initial, std::move(initial)}, shardCount{std::max<std::size_t>(1, readerShards)},
+          shards{std::make_unique<Shard[]>(shardCount)}
+    {
+    }
+
+    LeftRight(const LeftRight&) = delete;
+    LeftRight& operator=(const LeftRight&) = delete;
+
+    ReadHandle Get() const
+    {
+        return ReadHandle{*this};
+    }
+
+    // Calls read(const T&) inside a read section and returns its result.
+    template <typename Func>
+    decltype(auto) Read(Func read) const
+    {
+        const ReadHandle handle{*this};
+        return read(*handle);
+    }
+
+    // Replaces both instances with doc, copying all of T. Prefer Modify for small changes to a large T.
+    void Publish(T doc)
+    {
+        std::lock_guard<std::mutex> lk{writerMut};
+        const auto active = activeInstance.load(std::memory_order_relaxed);
+        instances[1 - active] = doc;
+        SwitchReaders(active);
+        instances[active] = std::move(doc);
+    }
+
+    // Applies mutate(T&) to both instances, it must do the same thing both times.
+    template <typename Mutate>
+    void Modify(Mutate mutate)
+    {
+        std::lock_guard<std::mutex> lk{writerMut};
+        const auto active = activeInstance.load(std::memory_order_relaxed);
+        mutate(instances[1 - active]);
+        SwitchReaders(active);
+        mutate(instances[active]);
+    }
+
+private:
+    // Readers per version index, a reader only touches the counters of its own shard.
+    struct alignas(kNoSharing) Shard
+    {
+        std::array<std::atomic_int64_t, 2> readers{};
+    };
+
+    std::size_t Home() const
+    {
+        thread_local const std::size_t threadIndex = nextThreadIndex.fetch_add(1, std::memory_order_relaxed);
+        return threadIndex % shardCount;
+    }
+
+    // Moves new readers to the other instance and waits until no reader can still be on the old one.
+    void SwitchReaders(std::uint32_t active)
+    {
+        activeInstance.store(1 - active, std::memory_order_seq_cst);
+
+        // A reader may have loaded versionIndex long before it arrives, so draining one indicator isn't enough:
+        // drain the idle one, point new readers at it, then drain the one they used before.
+        const auto previous = versionIndex.load(std::memory_order_relaxed);
+        const auto next = 1 - previous;
+        WaitForEmpty(next);
+        versionIndex.store(next, std::memory_order_seq_cst);
+        WaitForEmpty(previous);
+    }
+
+    void WaitForEmpty(std::uint32_t index) const
+    {
+        for (std::size_t i = 0; i < shardCount; ++i)
+            while (shards[i].readers[index].load(std::memory_order_seq_cst) != 0)
+                std::this_thread::yield();
+    }
+
+    static inline std::atomic_size_t nextThreadIndex{0};
+
+    std::array<T, 2> instances;
+    const std::size_t shardCount;
+    std::unique_ptr<Shard[]> shards;
+    std::mutex writerMut;
+    alignas(kNoSharing) std::atomic_uint32_t activeInstance{0};
+    std::atomic_uint32_t versionIndex{0};
+};
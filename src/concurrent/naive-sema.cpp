@@ -1,38 +1,9 @@
-#include <condition_variable>
+#include "naive-sema.h"
+
 #include <iostream>
-#include <mutex>
 #include <thread>
 #include <vector>
 
-class NaiveSemaphore
-{
-public:
-    NaiveSemaphore(unsigned int count = 0) : count{count}
-    {
-    }
-
-    void Post()
-    {
-        {
-            std::lock_guard<std::mutex> lk{mtx};
-            ++count;
-        }
-        cv.notify_one();
-    }
-
-    void Wait()
-    {
-        std::unique_lock<std::mutex> lk{mtx};
-        cv.wait(lk, [this]() { return count > 0; });
-        --count;
-    }
-
-private:
-    std::mutex mtx;
-    std::condition_variable cv;
-    unsigned int count = 0;
-};
-
 int main()
 {
     using namespace std::literals;
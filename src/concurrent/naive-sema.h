@@ -0,0 +1,33 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+
+class NaiveSemaphore
+{
+public:
+    NaiveSemaphore(unsigned int count = 0) : count{count}
+    {
+    }
+
+    void Post()
+    {
+        {
+            std::lock_guard<std::mutex> lk{mtx};
+            ++count;
+        }
+        cv.notify_one();
+    }
+
+    void Wait()
+    {
+        std::unique_lock<std::mutex> lk{mtx};
+        cv.wait(lk, [this]() { return count > 0; });
+        --count;
+    }
+
+private:
+    std::mutex mtx;
+    std::condition_variable cv;
+    unsigned int count = 0;
+};
@@ -0,0 +1,185 @@
+#include "left-right.h"
+#include "publish-shared-ptr.h"
+#include "seqlock.h"
+#include "spsc-triple-buffer.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+
+// Reader throughput of the publish-latest-value primitives as the number of readers grows, while one writer
+// keeps publishing a 4KB snapshot.
+// Usage: publish-bench [max readers, default 20]
+
+struct MarketState
+{
+    std::uint64_t version = 0;
+    std::array<double, 510> prices{};
+    std::uint64_t trailer = 0;
+};
+static_assert(sizeof(MarketState) == 4096);
+
+MarketState MakeState(std::uint64_t version)
+{
+    MarketState state;
+    state.version = version;
+    state.prices.fill(static_cast<double>(version));
+    state.trailer = version;
+    return state;
+}
+
+// Every reader checks the first and the last word, a torn snapshot fails the run.
+void Check(const MarketState& state)
+{
+    if (state.version != state.trailer)
+    {
+        std::cerr << "torn snapshot " << state.version << " / " << state.trailer << '\n';
+        std::abort();
+    }
+}
+
+// Adapters: Publish(state) on the writer thread, Read() on the reader threads.
+class SeqLockAdapter
+{
+public:
+    static constexpr std::size_t kMaxReaders = SIZE_MAX;
+
+    void Publish(const MarketState& state)
+    {
+        lock.Store(state);
+    }
+
+    void Read()
+    {
+        Check(lock.Load());
+    }
+
+private:
+    SeqLock<MarketState> lock;
+};
+
+class TrioAdapter
+{
+public:
+    static constexpr std::size_t kMaxReaders = 1; // single consumer
+
+    void Publish(const MarketState& state)
+    {
+        trio.Write() = state;
+        trio.Commit();
+    }
+
+    void Read()
+    {
+        Check(trio.Read());
+    }
+
+private:
+    Trio<MarketState> trio;
+};
+
+// The SharedResource family and LeftRight: Publish(T) and a Get() that dereferences to the current T.
+template <typename Resource>
+class PublisherAdapter
+{
+public:
+    static constexpr std::size_t kMaxReaders = SIZE_MAX;
+
+    PublisherAdapter()
+    {
+        resource.Publish(MarketState{});
+    }
+
+    void Publish(const MarketState& state)
+    {
+        resource.Publish(state);
+    }
+
+    void Read()
+    {
+        Check(*resource.Get());
+    }
+
+private:
+    Resource resource;
+};
+
+template <typename Adapter>
+void Bench(std::string_view name, std::size_t readers)
+{
+    constexpr auto kDuration = 200ms;
+    constexpr auto kPublishInterval = 10us;
+
+    Adapter adapter;
+    std::atomic_bool stop{false};
+    std::vector<std::uint64_t> reads(readers);
+
+    std::thread writer{[&]() {
+        for (std::uint64_t version = 1; !stop.load(std::memory_order_relaxed); ++version)
+        {
+            adapter.Publish(MakeState(version));
+            std::this_thread::sleep_for(kPublishInterval);
+        }
+    }};
+
+    std::vector<std::thread> threads;
+    for (std::size_t r = 0; r < readers; ++r)
+        threads.emplace_back([&, r]() {
+            std::uint64_t count = 0;
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                adapter.Read();
+                ++count;
+            }
+            reads[r] = count;
+        });
+
+    std::this_thread::sleep_for(kDuration);
+    stop.store(true, std::memory_order_relaxed);
+    writer.join();
+    for (auto& thread : threads)
+        thread.join();
+
+    std::uint64_t total = 0;
+    for (const auto count : reads)
+        total += count;
+    const auto seconds = std::chrono::duration<double>{kDuration}.count();
+    std::cout << std::left << std::setw(24) << name << std::right << std::setw(4) << readers
+              << " readers " << std::fixed << std::setprecision(2) << std::setw(10)
+              << static_cast<double>(total) / seconds / 1e6 << " M reads/s total " << std::setw(10)
+              << static_cast<double>(total) / seconds / 1e6 / static_cast<double>(readers) << " M reads/s per reader\n";
+}
+
+template <typename Adapter>
+void Sweep(std::string_view name, std::size_t maxReaders)
+{
+    for (std::size_t readers = 1; readers <= std::min(maxReaders, Adapter::kMaxReaders);
+         readers = readers < maxReaders && readers * 2 > maxReaders ? maxReaders : readers * 2)
+        Bench<Adapter>(name, readers);
+}
+
+int main(int argc, char* argv[])
+{
+    const std::size_t maxReaders = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20;
+
+    Sweep<SeqLockAdapter>("SeqLock", maxReaders);
+    Sweep<TrioAdapter>("Trio", maxReaders);
+    Sweep<PublisherAdapter<SharedResource<MarketState>>>("SharedResource", maxReaders);
+    Sweep<PublisherAdapter<SharedResourceNotReallyLockFree<MarketState>>>("atomic<shared_ptr>", maxReaders);
+    Sweep<PublisherAdapter<SharedResourceLockFree<MarketState>>>("SharedResourceLockFree", maxReaders);
+    Sweep<PublisherAdapter<SharedResourceRcu<MarketState>>>("SharedResourceRcu", maxReaders);
+    Sweep<PublisherAdapter<LeftRight<MarketState>>>("LeftRight", maxReaders);
+
+    return 0;
+}
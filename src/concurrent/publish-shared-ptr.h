@@ -0,0 +1,209 @@
+#pragma once
+
+#include "data-structures/lock-free/epoch-reclamation.h"
+#include "data-structures/lock-free/hazard-pointer.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+// Source: https://accu.org/journals/overload/32/183/teodorescu/
+
+template <typename T>
+class SharedResource
+{
+public:
+    void Publish(T doc)
+    {
+        std::lock_guard<std::mutex> lock{small_bottleneck};
+        published_doc = std::make_shared<const T>(std::move(doc));
+    }
+
+    std::shared_ptr<const T> Get()
+    {
+        std::lock_guard<std::mutex> lock{small_bottleneck};
+        return published_doc;
+    }
+
+private:
+    std::mutex small_bottleneck;
+    std::shared_ptr<const T> published_doc;
+};
+
+// Atomic shared ptr C++20 + libstdc++
+template <typename T>
+class SharedResourceNotReallyLockFree
+{
+public:
+    void Publish(T doc)
+    {
+        auto publish_doc = std::make_shared<const T>(std::move(doc));
+        published_doc.store(std::move(publish_doc), std::memory_order_release);
+    }
+
+    std::shared_ptr<const T> Get() const
+    {
+        return published_doc.load(std::memory_order_acquire);
+    }
+
+private:
+    std::atomic<std::shared_ptr<const T>> published_doc;
+
+    // Not really lock free.
+    // static_assert(std::atomic<std::shared_ptr<T>>::is_always_lock_free);
+};
+
+// Lock-free publisher: a reader protects the current document with a hazard pointer instead of bumping a shared
+// reference count, Publish swaps the pointer and retires the old document. A read retries only when a Publish
+// swapped the pointer under it.
+template <typename T>
+class SharedResourceLockFree
+{
+    struct Doc : HazardPointerObjBase<Doc>
+    {
+        explicit Doc(T doc) : doc{std::move(doc)}
+        {
+        }
+
+        T doc;
+    };
+
+public:
+    // Valid while the handle lives, must not outlive the calling thread.
+    class ReadHandle
+    {
+    public:
+        const T& operator*() const
+        {
+            return doc->doc;
+        }
+
+        const T* operator->() const
+        {
+            return &doc->doc;
+        }
+
+        explicit operator bool() const
+        {
+            return doc != nullptr;
+        }
+
+    private:
+        friend class SharedResourceLockFree;
+
+        ReadHandle(HazardPointerDomain& domain, const std::atomic<Doc*>& published)
+            : hazard{domain.MakeHazardPointer()}, doc{hazard.Protect(published)}
+        {
+        }
+
+        HazardPointer hazard;
+        const Doc* doc;
+    };
+
+    explicit SharedResourceLockFree(HazardPointerDomain& domain = DefaultHazardPointerDomain()) : domain{domain}
+    {
+    }
+
+    // No thread may read anymore.
+    ~SharedResourceLockFree()
+    {
+        delete published_doc.load(std::memory_order_relaxed);
+    }
+
+    SharedResourceLockFree(const SharedResourceLockFree&) = delete;
+    SharedResourceLockFree& operator=(const SharedResourceLockFree&) = delete;
+
+    void Publish(T doc)
+    {
+        // Order matters: a scan after the swap must see every reader that still protects the old document.
+        auto* old = published_doc.exchange(new Doc{std::move(doc)}, std::memory_order_seq_cst);
+        if (old != nullptr)
+            old->Retire(domain);
+    }
+
+    ReadHandle Get() const
+    {
+        return ReadHandle{domain, published_doc};
+    }
+
+private:
+    HazardPointerDomain& domain;
+    std::atomic<Doc*> published_doc{nullptr};
+};
+
+// Read-copy-update publisher: readers dereference a plain pointer inside an epoch section, Publish swaps the
+// pointer and retires the old version, which is freed once every reader that could still see it has left.
+// - A read pins the reader's own epoch record, readers write no shared cache line and never wait.
+// - Old versions are freed lazily in batches, Reclaim() waits for a grace period and frees them right away.
+// Meant for data that is read all the time and replaced rarely, like config or routing tables.
+template <typename T>
+class SharedResourceRcu
+{
+public:
+    // Valid while the handle lives, must not outlive the calling thread.
+    class ReadHandle
+    {
+    public:
+        const T& operator*() const
+        {
+            return *doc;
+        }
+
+        const T* operator->() const
+        {
+            return doc;
+        }
+
+        explicit operator bool() const
+        {
+            return doc != nullptr;
+        }
+
+    private:
+        friend class SharedResourceRcu;
+
+        ReadHandle(EpochDomain& domain, const std::atomic<T*>& published)
+            : guard{domain}, doc{published.load(std::memory_order_acquire)}
+        {
+        }
+
+        EpochDomain::Guard guard;
+        const T* doc;
+    };
+
+    explicit SharedResourceRcu(EpochDomain& domain = DefaultEpochDomain()) : domain{domain}
+    {
+    }
+
+    // No thread may read anymore.
+    ~SharedResourceRcu()
+    {
+        delete published_doc.load(std::memory_order_relaxed);
+    }
+
+    SharedResourceRcu(const SharedResourceRcu&) = delete;
+    SharedResourceRcu& operator=(const SharedResourceRcu&) = delete;
+
+    void Publish(T doc)
+    {
+        auto* old = published_doc.exchange(new T{std::move(doc)}, std::memory_order_acq_rel);
+        if (old != nullptr)
+            domain.Retire(old);
+    }
+
+    ReadHandle Get() const
+    {
+        return ReadHandle{domain, published_doc};
+    }
+
+    // Frees the versions this thread has published so far, must not be called while holding a ReadHandle.
+    void Reclaim()
+    {
+        domain.Synchronize();
+    }
+
+private:
+    EpochDomain& domain;
+    std::atomic<T*> published_doc{nullptr};
+};
@@ -0,0 +1,154 @@
+#include "fair-sema.h"
+#include "futex-sema.h"
+#include "naive-sema.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <semaphore>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+
+// Semaphore round trips:
+// - uncontended: Post() + Wait() on one thread, the count never drops to 0 in Wait()
+// - ping-pong: two threads hand a token back and forth through two semaphores, every Wait() may block
+// - spread: more threads than permits loop on Wait() + Post(), the spread of per-thread acquisitions shows
+//   how fair the semaphore is
+
+// Gives all semaphores the Post()/Wait() surface of NaiveSemaphore.
+template <typename Sema>
+struct StdSemaphore
+{
+    explicit StdSemaphore(std::ptrdiff_t count = 0) : sema{count}
+    {
+    }
+
+    void Post()
+    {
+        sema.release();
+    }
+
+    void Wait()
+    {
+        sema.acquire();
+    }
+
+    Sema sema;
+};
+
+template <typename Sema>
+double UncontendedNs(std::int64_t rounds)
+{
+    Sema sema;
+    const auto start = std::chrono::steady_clock::now();
+    for (std::int64_t i = 0; i < rounds; ++i)
+    {
+        sema.Post();
+        sema.Wait();
+    }
+    return std::chrono::duration<double, std::nano>{std::chrono::steady_clock::now() - start}.count() /
+           static_cast<double>(rounds);
+}
+
+template <typename Sema>
+double PingPongNs(std::int64_t rounds)
+{
+    Sema ping;
+    Sema pong;
+
+    std::thread other{[&]() {
+        for (std::int64_t i = 0; i < rounds; ++i)
+        {
+            ping.Wait();
+            pong.Post();
+        }
+    }};
+
+    const auto start = std::chrono::steady_clock::now();
+    for (std::int64_t i = 0; i < rounds; ++i)
+    {
+        ping.Post();
+        pong.Wait();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    other.join();
+
+    return std::chrono::duration<double, std::nano>{elapsed}.count() / static_cast<double>(rounds);
+}
+
+template <typename Sema>
+void Spread(std::string_view name)
+{
+    constexpr int kThreads = 8;
+    constexpr std::uint32_t kPermits = 2;
+    constexpr auto kDuration = 500ms;
+
+    Sema sema{kPermits};
+    std::atomic_bool stop{false};
+    std::vector<std::int64_t> acquisitions(kThreads);
+
+    std::vector<std::thread> threads;
+    threads.reserve(kThreads);
+    for (int i = 0; i < kThreads; ++i)
+        threads.emplace_back([&, i]() {
+            std::int64_t count = 0;
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                sema.Wait();
+                ++count;
+                // A little work while holding the permit.
+                const auto until = std::chrono::steady_clock::now() + 1us;
+                while (std::chrono::steady_clock::now() < until)
+                    ;
+                sema.Post();
+            }
+            acquisitions[i] = count;
+        });
+
+    std::this_thread::sleep_for(kDuration);
+    stop.store(true, std::memory_order_relaxed);
+    for (auto& t : threads)
+        t.join();
+
+    const auto [min, max] = std::ranges::minmax(acquisitions);
+    std::int64_t total = 0;
+    for (const auto count : acquisitions)
+        total += count;
+    std::cout << std::left << std::setw(24) << name << std::right << " " << kThreads << " threads, " << kPermits
+              << " permits: acquisitions per thread min " << std::setw(8) << min << " max " << std::setw(8) << max
+              << " mean " << std::setw(8) << total / kThreads << " max/min " << std::fixed << std::setprecision(1)
+              << static_cast<double>(max) / static_cast<double>(std::max<std::int64_t>(min, 1)) << '\n';
+}
+
+template <typename Sema>
+void Bench(std::string_view name)
+{
+    constexpr std::int64_t kUncontendedRounds = 10'000'000;
+    constexpr std::int64_t kPingPongRounds = 200'000;
+
+    std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(1)
+              << " uncontended " << std::setw(8) << UncontendedNs<Sema>(kUncontendedRounds) << "ns"
+              << " ping-pong " << std::setw(8) << PingPongNs<Sema>(kPingPongRounds) << "ns per round trip\n";
+}
+
+int main()
+{
+    Bench<NaiveSemaphore>("NaiveSemaphore");
+    Bench<FutexSemaphore>("FutexSemaphore");
+    Bench<FairSemaphore>("FairSemaphore");
+    Bench<StdSemaphore<std::counting_semaphore<>>>("std::counting_semaphore");
+    Bench<StdSemaphore<std::binary_semaphore>>("std::binary_semaphore");
+
+    Spread<NaiveSemaphore>("NaiveSemaphore");
+    Spread<FutexSemaphore>("FutexSemaphore");
+    Spread<FairSemaphore>("FairSemaphore");
+    Spread<StdSemaphore<std::counting_semaphore<>>>("std::counting_semaphore");
+
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include "seqlock.h"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+// A snapshot is consistent when every field carries the same version.
+struct Snapshot
+{
+    std::uint64_t version = 0;
+    std::array<std::uint64_t, 63> fields{};
+    std::uint64_t trailer = 0;
+};
+
+int main()
+{
+    constexpr std::uint64_t kUpdates = 100'000;
+    constexpr int kReaders = 4;
+
+    SeqLock<Snapshot> state;
+    std::atomic_bool done{false};
+
+    auto writer = std::async(std::launch::async, [&]() {
+        Snapshot snapshot;
+        for (std::uint64_t v = 1; v <= kUpdates; ++v)
+        {
+            snapshot.version = v;
+            snapshot.fields.fill(v);
+            snapshot.trailer = v;
+            state.Store(snapshot);
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    std::vector<std::future<std::uint64_t>> readers;
+    for (int i = 0; i < kReaders; ++i)
+        readers.emplace_back(std::async(std::launch::async, [&]() {
+            std::uint64_t reads = 0;
+            std::uint64_t last = 0;
+            while (!done.load(std::memory_order_acquire))
+            {
+                const auto snapshot = state.Load();
+                for (const auto field : snapshot.fields)
+                    if (field != snapshot.version)
+                        throw std::logic_error{"torn snapshot"};
+                if (snapshot.trailer != snapshot.version || snapshot.version < last)
+                    throw std::logic_error{"torn or stale snapshot"};
+                last = snapshot.version;
+                ++reads;
+            }
+            return reads;
+        }));
+
+    writer.get();
+    for (auto& reader : readers)
+        std::cout << "reader: " << reader.get() << " consistent snapshots\n";
+
+    std::cout << "final version " << state.Load().version << ", seqlock version " << state.Version() << '\n';
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "cpu.h"
+
+// Source: H. Boehm, Can Seqlocks Get Along With Programming Language Memory Models?
+
+// Sequence lock: writers update the value in place, readers copy it out without writing shared memory.
+// - The version is odd while a write is in progress, a reader that saw an odd version or a version change
+//   during its copy retries.
+// - The value is stored as relaxed atomic words, so a torn read is a retry instead of a data race (the
+//   byte-wise atomic memcpy of P1478).
+// - Readers never block the writer, with a busy writer readers may retry, they are lock-free not wait-free.
+template <typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock copies T as raw bytes");
+
+public:
+    SeqLock() : SeqLock(T{})
+    {
+    }
+
+    explicit SeqLock(const T& val)
+    {
+        StoreWords(val);
+    }
+
+    SeqLock(const SeqLock&) = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+
+    // Writers are serialized by the odd version, a second writer spins until the first is done.
+    void Store(const T& val)
+    {
+        const auto odd = BeginWrite();
+        StoreWords(val);
+        version.store(odd + 1, std::memory_order_release);
+    }
+
+    // Copies the value out, retries while a write is in progress.
+    T Load() const
+    {
+        T res;
+        while (!TryLoad(res))
+            CpuRelax();
+        return res;
+    }
+
+    // One optimistic attempt, false if it raced with a writer.
+    bool TryLoad(T& out) const
+    {
+        const auto before = version.load(std::memory_order_acquire);
+        if ((before & 1) != 0)
+            return false;
+
+        std::array<std::uint64_t, kWords> copy;
+        for (std::size_t i = 0; i < kWords; ++i)
+            copy[i] = words[i].load(std::memory_order_relaxed);
+
+        // Order matters: the data loads must not move below the version re-check.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (version.load(std::memory_order_relaxed) != before)
+            return false;
+
+        std::memcpy(static_cast<void*>(&out), copy.data(), sizeof(T));
+        return true;
+    }
+
+    // Twice the number of completed writes, changes whenever the value does.
+    [[nodiscard]] std::uint64_t Version() const
+    {
+        return version.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr std::size_t kWords = (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+    // Makes the version odd and returns it.
+    std::uint64_t BeginWrite()
+    {
+        auto current = version.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            if ((current & 1) == 0 &&
+                version.compare_exchange_weak(current, current + 1, std::memory_order_acquire,
+                                              std::memory_order_relaxed))
+                break;
+
+            CpuRelax();
+            current = version.load(std::memory_order_relaxed);
+        }
+
+        // Order matters: the odd version must be visible before any of the data stores.
+        std::atomic_thread_fence(std::memory_order_release);
+        return current + 1;
+    }
+
+    void StoreWords(const T& val)
+    {
+        std::array<std::uint64_t, kWords> copy{};
+        std::memcpy(copy.data(), &val, sizeof(T));
+        for (std::size_t i = 0; i < kWords; ++i)
+            words[i].store(copy[i], std::memory_order_relaxed);
+    }
+
+    alignas(kNoSharing) std::atomic_uint64_t version{0};
+    alignas(kNoSharing) std::array<std::atomic_uint64_t, kWords> words;
+};
@@ -0,0 +1,214 @@
+#include "cpu.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <optional>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+// Source: https://rigtorp.se/ringbuffer/
+
+// Lossless single producer/single consumer ring buffer, unlike Trio every pushed value is popped once.
+// - Positions only grow, the slot is position & kMask and size is tail - head.
+// - Each side caches the other side's position and only reloads it (a cache miss) when the cached
+//   value says the ring is full/empty.
+// - Batch calls publish the whole span with a single release store.
+template <typename T, std::size_t Capacity>
+class SpscRingBuffer
+{
+    static_assert(Capacity >= 2 && std::has_single_bit(Capacity), "Capacity must be a power of two");
+
+public:
+    SpscRingBuffer() = default;
+    SpscRingBuffer(const SpscRingBuffer&) = delete;
+    SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+    ~SpscRingBuffer()
+    {
+        const auto tail = m_tail.load(std::memory_order_relaxed);
+        for (auto head = m_head.load(std::memory_order_relaxed); head != tail; ++head)
+            Slot(head)->~T();
+    }
+
+    // Producer side.
+    template <typename... Args>
+    bool TryEmplace(Args&&... args)
+    {
+        const auto tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cachedHead == Capacity)
+        {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail - m_cachedHead == Capacity)
+                return false;
+        }
+
+        ::new (static_cast<void*>(m_slots[tail & kMask].data)) T(std::forward<Args>(args)...);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPush(const T& val)
+    {
+        return TryEmplace(val);
+    }
+
+    bool TryPush(T&& val)
+    {
+        return TryEmplace(std::move(val));
+    }
+
+    // Producer side, copies as many values as fit and returns how many.
+    std::size_t TryPushN(std::span<const T> vals)
+    {
+        const auto tail = m_tail.load(std::memory_order_relaxed);
+        if (Capacity - (tail - m_cachedHead) < vals.size())
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+
+        const auto count = std::min(vals.size(), Capacity - (tail - m_cachedHead));
+        for (std::size_t i = 0; i < count; ++i)
+            ::new (static_cast<void*>(m_slots[(tail + i) & kMask].data)) T(vals[i]);
+
+        if (count != 0)
+            m_tail.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer side.
+    std::optional<T> TryPop()
+    {
+        const auto head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cachedTail)
+        {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cachedTail)
+                return std::nullopt;
+        }
+
+        auto* slot = Slot(head);
+        std::optional<T> res{std::move(*slot)};
+        slot->~T();
+        m_head.store(head + 1, std::memory_order_release);
+        return res;
+    }
+
+    // Consumer side, moves up to out.size() values into out and returns how many.
+    std::size_t TryPopN(std::span<T> out)
+    {
+        const auto head = m_head.load(std::memory_order_relaxed);
+        if (m_cachedTail - head < out.size())
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+
+        const auto count = std::min(out.size(), m_cachedTail - head);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            auto* slot = Slot(head + i);
+            out[i] = std::move(*slot);
+            slot->~T();
+        }
+
+        if (count != 0)
+            m_head.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    // Approximate unless called from the producer or consumer while the other side is idle.
+    [[nodiscard]] std::size_t Size() const
+    {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr std::size_t kMask = Capacity - 1;
+
+    struct Storage
+    {
+        alignas(T) std::byte data[sizeof(T)];
+    };
+
+    T* Slot(std::size_t pos)
+    {
+        return std::launder(reinterpret_cast<T*>(m_slots[pos & kMask].data));
+    }
+
+    alignas(kNoSharing) std::atomic_size_t m_tail{0}; // written by producer
+    std::size_t m_cachedHead{0};                      // only producer can access
+    alignas(kNoSharing) std::atomic_size_t m_head{0}; // written by consumer
+    std::size_t m_cachedTail{0};                      // only consumer can access
+    alignas(kNoSharing) Storage m_slots[Capacity];
+};
+
+int main()
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr std::uint64_t kMessages = 20'000'000;
+    constexpr std::size_t kBatch = 64;
+    auto channel = std::make_unique<SpscRingBuffer<std::uint64_t, 4096>>();
+
+    const auto start = Clock::now();
+
+    auto producer = std::async(std::launch::async, [&]() {
+        std::uint64_t batch[kBatch];
+        std::uint64_t next = 1;
+        while (next <= kMessages)
+        {
+            const auto count = std::min<std::uint64_t>(kBatch, kMessages - next + 1);
+            for (std::size_t i = 0; i < count; ++i)
+                batch[i] = next + i;
+
+            std::span<const std::uint64_t> pending{batch, count};
+            while (!pending.empty())
+            {
+                const auto pushed = channel->TryPushN(pending);
+                if (pushed == 0)
+                    std::this_thread::yield();
+                pending = pending.subspan(pushed);
+            }
+            next += count;
+        }
+    });
+
+    auto consumer = std::async(std::launch::async, [&]() {
+        std::uint64_t batch[kBatch];
+        std::uint64_t expected = 1;
+        while (expected <= kMessages)
+        {
+            const auto count = channel->TryPopN(batch);
+            if (count == 0)
+                std::this_thread::yield();
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                if (batch[i] != expected)
+                    return false;
+                ++expected;
+            }
+        }
+        return true;
+    });
+
+    producer.get();
+    const bool inOrder = consumer.get();
+
+    const auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    std::cout << kMessages << " messages " << (inOrder ? "in order" : "OUT OF ORDER") << ", "
+              << kMessages / elapsed / 1e6 << " M msg/s\n";
+
+    // Single value calls.
+    SpscRingBuffer<std::unique_ptr<int>, 2> small;
+    std::cout << "push " << small.TryPush(std::make_unique<int>(1)) << small.TryPush(std::make_unique<int>(2))
+              << small.TryPush(std::make_unique<int>(3)) << '\n';
+    while (auto val = small.TryPop())
+        std::cout << " <- " << **val << '\n';
+
+    return 0;
+}
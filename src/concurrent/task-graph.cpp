@@ -0,0 +1,81 @@
+#include "task-graph.h"
+#include "thread-pool.h"
+
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+
+int main()
+{
+    ThreadPool pool{ThreadPoolOptions{.threadCount = 4}};
+
+    // parse -> 4 transforms -> join -> reduce
+    std::vector<int> input;
+    std::vector<std::vector<int>> partial(4);
+    std::vector<int> joined;
+    long long result = 0;
+
+    TaskGraph graph;
+    const auto parse = graph.AddNode([&]() {
+        input.resize(4000);
+        std::iota(input.begin(), input.end(), 1);
+        std::this_thread::sleep_for(5ms);
+    });
+
+    const auto join = graph.AddNode([&]() {
+        joined.clear();
+        for (const auto& part : partial)
+            joined.insert(joined.end(), part.begin(), part.end());
+    });
+
+    for (size_t i = 0; i < partial.size(); ++i)
+    {
+        const auto transform = graph.AddNode([&, i]() {
+            const auto chunk = input.size() / partial.size();
+            partial[i].assign(input.begin() + i * chunk, input.begin() + (i + 1) * chunk);
+            for (auto& val : partial[i])
+                val *= 2;
+            std::this_thread::sleep_for(1ms * (i + 1));
+        });
+
+        graph.AddEdge(parse, transform);
+        graph.AddEdge(transform, join);
+    }
+
+    const auto reduce = graph.AddNode([&]() { result = std::accumulate(joined.begin(), joined.end(), 0LL); });
+    graph.AddEdge(join, reduce);
+
+    const auto toUs = [](std::chrono::nanoseconds ns) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(ns);
+    };
+    for (int run = 1; run <= 3; ++run)
+    {
+        const auto stats = graph.Run(pool);
+        std::cout << "Run " << run << ": result " << result << ", wall " << toUs(stats.wall).count() << "us, work "
+                  << toUs(stats.work).count() << "us, critical path " << toUs(stats.criticalPath).count()
+                  << "us through nodes";
+        for (const auto id : stats.criticalPathNodes)
+            std::cout << ' ' << id;
+        std::cout << '\n';
+    }
+
+    TaskGraph failing;
+    const auto first = failing.AddNode([]() { throw std::runtime_error{"transform failed"}; });
+    const auto second = failing.AddNode([]() { std::cout << "Never printed\n"; });
+    failing.AddEdge(first, second);
+    try
+    {
+        failing.Run(pool);
+    }
+    catch (const std::exception& e)
+    {
+        std::cout << "Run failed: " << e.what() << '\n';
+    }
+
+    return 0;
+}
@@ -0,0 +1,234 @@
+#pragma once
+
+#include "thread-pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Dependency graph of tasks, declared once and run any number of times on a ThreadPool.
+// - Every node has an atomic count of unfinished predecessors, reset at the start of a run.
+// - The node that finishes a predecessor count runs next: the first successor that becomes ready
+//   continues inline on the same thread, only the others are posted to the pool.
+// - Nobody blocks on a future, the thread that called Run() helps with pool work until the graph
+//   is done.
+class TaskGraph
+{
+public:
+    using NodeId = std::size_t;
+    using Clock = std::chrono::steady_clock;
+
+    struct RunStats
+    {
+        std::chrono::nanoseconds wall{0};
+        // Sum of all node run times.
+        std::chrono::nanoseconds work{0};
+        // Longest chain of dependent node run times, the lower bound of wall with infinite workers.
+        std::chrono::nanoseconds criticalPath{0};
+        std::vector<NodeId> criticalPathNodes;
+    };
+
+    TaskGraph() = default;
+    TaskGraph(const TaskGraph&) = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+
+    template <typename CallableType>
+    NodeId AddNode(CallableType callable)
+    {
+        nodes.emplace_back(Task{std::move(callable)});
+        order.clear();
+        return nodes.size() - 1;
+    }
+
+    // 'to' runs after 'from' has finished.
+    void AddEdge(NodeId from, NodeId to)
+    {
+        if (from >= nodes.size() || to >= nodes.size())
+            throw std::out_of_range{"TaskGraph::AddEdge: unknown node"};
+
+        nodes[from].successors.push_back(to);
+        ++nodes[to].predecessorCount;
+        order.clear();
+    }
+
+    [[nodiscard]] std::size_t Size() const
+    {
+        return nodes.size();
+    }
+
+    // Runs every node once and blocks until all of them are done, one run at a time per graph.
+    // Once a node throws the remaining nodes are skipped and the exception is rethrown.
+    // Throws std::logic_error if the graph has a cycle.
+    RunStats Run(ThreadPool& pool)
+    {
+        if (nodes.empty())
+            return {};
+
+        if (order.empty())
+            order = TopologicalOrder();
+
+        for (auto& node : nodes)
+            node.pending.store(node.predecessorCount, std::memory_order_relaxed);
+        unfinished.store(nodes.size(), std::memory_order_relaxed);
+        failed.clear();
+        error = nullptr;
+
+        const auto start = Clock::now();
+
+        std::vector<NodeId> roots;
+        for (NodeId id = 0; id < nodes.size(); ++id)
+            if (nodes[id].predecessorCount == 0)
+                roots.push_back(id);
+
+        for (size_t i = 1; i < roots.size(); ++i)
+            pool.Post([this, &pool, id = roots[i]]() { Execute(pool, id); });
+        Execute(pool, roots.front());
+
+        while (unfinished.load(std::memory_order_acquire) != 0)
+            if (!pool.RunPendingTask())
+                std::this_thread::yield();
+
+        const auto end = Clock::now();
+
+        if (error)
+            std::rethrow_exception(error);
+
+        return Stats(end - start);
+    }
+
+private:
+    struct Node
+    {
+        explicit Node(Task task) : task{std::move(task)}
+        {
+        }
+
+        Node(Node&& other) noexcept
+            : task{std::move(other.task)}, successors{std::move(other.successors)},
+              predecessorCount{other.predecessorCount}
+        {
+        }
+
+        Task task;
+        std::vector<NodeId> successors;
+        std::size_t predecessorCount = 0;
+
+        // Per run state.
+        std::atomic_size_t pending{0};
+        Clock::time_point started;
+        Clock::time_point finished;
+    };
+
+    static constexpr NodeId kNone = std::numeric_limits<NodeId>::max();
+
+    // Decrementing unfinished is the last access to the graph for a thread that has nothing to
+    // continue with, Run() may return right after.
+    void Execute(ThreadPool& pool, NodeId id)
+    {
+        while (id != kNone)
+        {
+            auto& node = nodes[id];
+            node.started = Clock::now();
+            if (!failed.test(std::memory_order_relaxed))
+            {
+                try
+                {
+                    node.task();
+                }
+                catch (...)
+                {
+                    if (!failed.test_and_set(std::memory_order_relaxed))
+                        error = std::current_exception();
+                }
+            }
+            node.finished = Clock::now();
+
+            NodeId next = kNone;
+            for (const auto succ : node.successors)
+            {
+                if (nodes[succ].pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                    continue;
+
+                if (next == kNone)
+                    next = succ;
+                else
+                    pool.Post([this, &pool, succ]() { Execute(pool, succ); });
+            }
+
+            unfinished.fetch_sub(1, std::memory_order_release);
+            id = next;
+        }
+    }
+
+    // Kahn's algorithm.
+    std::vector<NodeId> TopologicalOrder() const
+    {
+        std::vector<std::size_t> indegree(nodes.size());
+        std::vector<NodeId> res;
+        res.reserve(nodes.size());
+        for (NodeId id = 0; id < nodes.size(); ++id)
+        {
+            indegree[id] = nodes[id].predecessorCount;
+            if (indegree[id] == 0)
+                res.push_back(id);
+        }
+
+        for (size_t i = 0; i < res.size(); ++i)
+            for (const auto succ : nodes[res[i]].successors)
+                if (--indegree[succ] == 0)
+                    res.push_back(succ);
+
+        if (res.size() != nodes.size())
+            throw std::logic_error{"TaskGraph has a cycle"};
+
+        return res;
+    }
+
+    RunStats Stats(std::chrono::nanoseconds wall) const
+    {
+        RunStats stats;
+        stats.wall = wall;
+
+        // Longest path ending in each node, in topological order.
+        std::vector<std::chrono::nanoseconds> longest(nodes.size());
+        std::vector<std::chrono::nanoseconds> bestPredecessor(nodes.size());
+        std::vector<NodeId> via(nodes.size(), kNone);
+        NodeId last = order.front();
+        for (const auto id : order)
+        {
+            const auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(nodes[id].finished -
+                                                                                       nodes[id].started);
+            stats.work += duration;
+            longest[id] = bestPredecessor[id] + duration;
+            if (longest[id] > longest[last])
+                last = id;
+
+            for (const auto succ : nodes[id].successors)
+                if (via[succ] == kNone || longest[id] > bestPredecessor[succ])
+                {
+                    bestPredecessor[succ] = longest[id];
+                    via[succ] = id;
+                }
+        }
+
+        stats.criticalPath = longest[last];
+        for (auto id = last; id != kNone; id = via[id])
+            stats.criticalPathNodes.push_back(id);
+        std::ranges::reverse(stats.criticalPathNodes);
+
+        return stats;
+    }
+
+    std::vector<Node> nodes;
+    std::vector<NodeId> order;
+    std::atomic_size_t unfinished{0};
+    std::atomic_flag failed;
+    std::exception_ptr error;
+};
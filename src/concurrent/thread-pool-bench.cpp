@@ -0,0 +1,73 @@
+#include "thread-pool.h"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+
+// Compares the old yield-forever idle loop with spin-then-park:
+// - wake-up latency: time from Post() on an idle pool until the task starts running
+// - idle CPU: CPU time burnt by the process while the pool has nothing to do
+
+std::chrono::nanoseconds CpuTime()
+{
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    const auto toNs = [](const timeval& tv) {
+        return std::chrono::seconds{tv.tv_sec} + std::chrono::microseconds{tv.tv_usec};
+    };
+    return toNs(usage.ru_utime) + toNs(usage.ru_stime);
+}
+
+void Bench(std::string_view name, ThreadPoolOptions options)
+{
+    constexpr int kSamples = 200;
+
+    ThreadPool pool{options};
+
+    std::vector<std::chrono::nanoseconds> latencies;
+    latencies.reserve(kSamples);
+    for (int i = 0; i < kSamples; ++i)
+    {
+        // Long enough for an adaptive worker to run out of spins and park.
+        std::this_thread::sleep_for(2ms);
+
+        std::promise<std::chrono::steady_clock::time_point> started;
+        auto startedFut = started.get_future();
+        const auto posted = std::chrono::steady_clock::now();
+        pool.Post([&started]() { started.set_value(std::chrono::steady_clock::now()); });
+        latencies.emplace_back(startedFut.get() - posted);
+    }
+    std::ranges::sort(latencies);
+
+    const std::chrono::nanoseconds idleWall = 1s;
+    const auto cpuBefore = CpuTime();
+    std::this_thread::sleep_for(idleWall);
+    const auto idleCpu = CpuTime() - cpuBefore;
+
+    const auto toUs = [](std::chrono::nanoseconds ns) { return std::chrono::duration<double, std::micro>{ns}.count(); };
+    std::cout << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(1)
+              << " wake-up p50 " << std::setw(9) << toUs(latencies[kSamples / 2]) << "us"
+              << " p99 " << std::setw(9) << toUs(latencies[kSamples * 99 / 100]) << "us"
+              << " idle CPU " << std::setw(6)
+              << 100.0 * static_cast<double>(idleCpu.count()) / static_cast<double>(idleWall.count())
+              << "% of one core (" << pool.Size() << " workers)\n";
+}
+
+int main()
+{
+    Bench("yield loop", ThreadPoolOptions{.spinCount = 0, .yieldCount = 0, .park = false});
+    Bench("spin+park", ThreadPoolOptions{});
+    Bench("park at once", ThreadPoolOptions{.spinCount = 0, .yieldCount = 0, .park = true});
+
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include "thread-pool-coro.h"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <syncstream>
+#include <thread>
+#include <vector>
+
+using namespace std::literals;
+
+CoTask<int> Square(ThreadPool& pool, int val)
+{
+    co_await pool.Schedule();
+    co_return val * val;
+}
+
+CoTask<int> SumOfSquares(ThreadPool& pool, int count)
+{
+    std::vector<CoTask<int>> tasks;
+    for (int i = 1; i <= count; ++i)
+        tasks.push_back(Square(pool, i));
+
+    int sum = 0;
+    for (const int val : co_await WhenAll(std::move(tasks)))
+        sum += val;
+    co_return sum;
+}
+
+CoTask<std::string> Fetch(ThreadPool& pool, std::string name, std::chrono::milliseconds latency)
+{
+    co_await pool.Schedule();
+    std::this_thread::sleep_for(latency);
+    co_return name;
+}
+
+CoTask<void> Fail(ThreadPool& pool)
+{
+    co_await pool.Schedule();
+    throw std::runtime_error{"request failed"};
+}
+
+// Each coroutine hops back onto the pool a few times, a single worker interleaves all of them.
+CoTask<void> Hop(ThreadPool& pool, std::atomic_int& hops)
+{
+    for (int i = 0; i < 10; ++i)
+    {
+        co_await pool.Schedule();
+        ++hops;
+    }
+}
+
+int main()
+{
+    ThreadPool pool{ThreadPoolOptions{.threadCount = 2}};
+
+    std::cout << "Sum of squares 1..100: " << SyncWait(SumOfSquares(pool, 100)) << '\n';
+
+    std::vector<CoTask<std::string>> replicas;
+    replicas.push_back(Fetch(pool, "slow replica", 200ms));
+    replicas.push_back(Fetch(pool, "fast replica", 10ms));
+    const auto [index, name] = SyncWait(WhenAny(std::move(replicas)));
+    std::cout << "WhenAny: first answer from #" << index << ' ' << name << '\n';
+
+    try
+    {
+        SyncWait(Fail(pool));
+    }
+    catch (const std::exception& e)
+    {
+        std::cout << "Exception propagated to the awaiter: " << e.what() << '\n';
+    }
+
+    ThreadPool single{ThreadPoolOptions{.threadCount = 1}};
+    std::atomic_int hops{0};
+    std::vector<CoTask<void>> hoppers;
+    for (int i = 0; i < 10000; ++i)
+        hoppers.push_back(Hop(single, hops));
+    SyncWait(WhenAll(std::move(hoppers)));
+    std::cout << "10000 coroutines on one worker made " << hops << " hops\n";
+
+    return 0;
+}
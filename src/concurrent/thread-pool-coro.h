@@ -0,0 +1,540 @@
+#pragma once
+
+#include "thread-pool.h"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// Coroutine support for ThreadPool:
+// - co_await pool.Schedule() hops onto a pool worker (see ThreadPool::Schedule()).
+// - CoTask<T> is a lazy coroutine, it starts when awaited and resumes its awaiter through
+//   symmetric transfer, so chains of co_awaits don't grow the stack.
+// - WhenAll / WhenAny combine CoTasks, SyncWait blocks a plain thread until a CoTask is done.
+// Named CoTask because Task already is the pool's type-erased callable.
+
+// Per-thread free lists of coroutine frames in 64-byte size classes.
+// Pool workers create and destroy frames all the time, after warm-up a frame is a pop from the
+// worker's own list instead of a trip to malloc. A frame freed on another thread simply moves to
+// that thread's lists.
+class FramePool
+{
+public:
+    static void* Allocate(std::size_t size)
+    {
+        const auto sizeClass = SizeClass(size);
+        if (sizeClass >= kClasses)
+            return ::operator new(size);
+
+        auto& lists = LocalLists();
+        if (auto* block = lists.heads[sizeClass])
+        {
+            lists.heads[sizeClass] = block->next;
+            --lists.counts[sizeClass];
+            return block;
+        }
+
+        return ::operator new((sizeClass + 1) * kGranularity);
+    }
+
+    static void Deallocate(void* ptr, std::size_t size) noexcept
+    {
+        const auto sizeClass = SizeClass(size);
+        auto& lists = LocalLists();
+        if (sizeClass >= kClasses || lists.counts[sizeClass] >= kMaxCached)
+        {
+            ::operator delete(ptr);
+            return;
+        }
+
+        lists.heads[sizeClass] = ::new (ptr) FreeBlock{lists.heads[sizeClass]};
+        ++lists.counts[sizeClass];
+    }
+
+private:
+    static constexpr std::size_t kGranularity = 64;
+    static constexpr std::size_t kClasses = 16;
+    static constexpr std::size_t kMaxCached = 256;
+
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    struct Lists
+    {
+        Lists() = default;
+        Lists(const Lists&) = delete;
+        Lists& operator=(const Lists&) = delete;
+
+        ~Lists()
+        {
+            for (auto* head : heads)
+                while (head)
+                    ::operator delete(std::exchange(head, head->next));
+        }
+
+        std::array<FreeBlock*, kClasses> heads{};
+        std::array<std::size_t, kClasses> counts{};
+    };
+
+    static constexpr std::size_t SizeClass(std::size_t size)
+    {
+        return (size + kGranularity - 1) / kGranularity - 1;
+    }
+
+    static Lists& LocalLists()
+    {
+        static thread_local Lists lists;
+        return lists;
+    }
+};
+
+template <typename T>
+class CoTask;
+
+// Frame allocation, continuation and exception handling shared by all CoTask promises.
+class CoPromiseBase
+{
+public:
+    static void* operator new(std::size_t size)
+    {
+        return FramePool::Allocate(size);
+    }
+
+    static void operator delete(void* ptr, std::size_t size) noexcept
+    {
+        FramePool::Deallocate(ptr, size);
+    }
+
+    std::suspend_always initial_suspend() const noexcept
+    {
+        return {};
+    }
+
+    // Symmetric transfer to whoever awaited us.
+    struct FinalAwaiter
+    {
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) const noexcept
+        {
+            auto continuation = handle.promise().continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept
+        {
+        }
+    };
+
+    FinalAwaiter final_suspend() const noexcept
+    {
+        return {};
+    }
+
+    void unhandled_exception() noexcept
+    {
+        error = std::current_exception();
+    }
+
+    std::coroutine_handle<> continuation;
+
+protected:
+    void RethrowIfFailed() const
+    {
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+private:
+    std::exception_ptr error;
+};
+
+template <typename T>
+class CoPromise : public CoPromiseBase
+{
+public:
+    CoTask<T> get_return_object() noexcept;
+
+    template <typename U>
+    void return_value(U&& val)
+    {
+        value.emplace(std::forward<U>(val));
+    }
+
+    T TakeResult()
+    {
+        RethrowIfFailed();
+        return std::move(*value);
+    }
+
+private:
+    std::optional<T> value;
+};
+
+template <>
+class CoPromise<void> : public CoPromiseBase
+{
+public:
+    CoTask<void> get_return_object() noexcept;
+
+    void return_void() const noexcept
+    {
+    }
+
+    void TakeResult() const
+    {
+        RethrowIfFailed();
+    }
+};
+
+template <typename T = void>
+class [[nodiscard]] CoTask
+{
+public:
+    using promise_type = CoPromise<T>;
+
+    explicit CoTask(std::coroutine_handle<promise_type> handle) : handle{handle}
+    {
+    }
+
+    CoTask(CoTask&& other) noexcept : handle{std::exchange(other.handle, nullptr)}
+    {
+    }
+
+    CoTask& operator=(CoTask&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (handle)
+                handle.destroy();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+
+    CoTask(const CoTask&) = delete;
+    CoTask& operator=(const CoTask&) = delete;
+
+    ~CoTask()
+    {
+        if (handle)
+            handle.destroy();
+    }
+
+    // Starts the task (or waits for it if it already started) and returns its result.
+    auto operator co_await() noexcept
+    {
+        struct Awaiter : ReadyAwaiter
+        {
+            T await_resume()
+            {
+                return this->handle.promise().TakeResult();
+            }
+        };
+
+        return Awaiter{{handle}};
+    }
+
+    // Like co_await but leaves the result in the task, a later co_await returns it without suspending.
+    auto WhenReady() noexcept
+    {
+        return ReadyAwaiter{handle};
+    }
+
+private:
+    struct ReadyAwaiter
+    {
+        bool await_ready() const noexcept
+        {
+            return !handle || handle.done();
+        }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) const noexcept
+        {
+            handle.promise().continuation = awaiting;
+            return handle;
+        }
+
+        void await_resume() const noexcept
+        {
+        }
+
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+template <typename T>
+CoTask<T> CoPromise<T>::get_return_object() noexcept
+{
+    return CoTask<T>{std::coroutine_handle<CoPromise<T>>::from_promise(*this)};
+}
+
+inline CoTask<void> CoPromise<void>::get_return_object() noexcept
+{
+    return CoTask<void>{std::coroutine_handle<CoPromise<void>>::from_promise(*this)};
+}
+
+// Eagerly started coroutine that destroys itself when it's done, used to drive CoTasks from
+// code that isn't awaiting them directly.
+struct DetachedCoroutine
+{
+    struct promise_type
+    {
+        static void* operator new(std::size_t size)
+        {
+            return FramePool::Allocate(size);
+        }
+
+        static void operator delete(void* ptr, std::size_t size) noexcept
+        {
+            FramePool::Deallocate(ptr, size);
+        }
+
+        DetachedCoroutine get_return_object() const noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never initial_suspend() const noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never final_suspend() const noexcept
+        {
+            return {};
+        }
+
+        void return_void() const noexcept
+        {
+        }
+
+        void unhandled_exception() const noexcept
+        {
+            std::terminate();
+        }
+    };
+};
+
+// Starts every task and resumes the awaiting coroutine on the thread that completes the last one.
+// The extra pending count belongs to await_suspend itself, so a task that completes while the
+// others are still being started can't resume the awaiter before it's fully suspended.
+template <typename T>
+class WhenAllAwaiter
+{
+public:
+    explicit WhenAllAwaiter(std::vector<CoTask<T>>& tasks) : tasks{tasks}, pending{tasks.size() + 1}
+    {
+    }
+
+    bool await_ready() const noexcept
+    {
+        return tasks.empty();
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        awaiting = handle;
+        for (auto& task : tasks)
+            Drive(task, *this);
+
+        return pending.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+
+    void await_resume() const noexcept
+    {
+    }
+
+private:
+    static DetachedCoroutine Drive(CoTask<T>& task, WhenAllAwaiter& self)
+    {
+        co_await task.WhenReady();
+        if (self.pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            self.awaiting.resume();
+    }
+
+    std::vector<CoTask<T>>& tasks;
+    std::atomic_size_t pending;
+    std::coroutine_handle<> awaiting;
+};
+
+// Completes when all tasks have completed. Rethrows the exception of the first failed task
+// (in vector order).
+template <typename T>
+CoTask<std::conditional_t<std::is_void_v<T>, void, std::vector<T>>> WhenAll(std::vector<CoTask<T>> tasks)
+{
+    co_await WhenAllAwaiter<T>{tasks};
+
+    if constexpr (std::is_void_v<T>)
+    {
+        for (auto& task : tasks)
+            co_await task;
+    }
+    else
+    {
+        std::vector<T> res;
+        res.reserve(tasks.size());
+        for (auto& task : tasks)
+            res.push_back(co_await task);
+        co_return res;
+    }
+}
+
+// Shared by WhenAny and its drivers, the losing tasks keep running after the awaiter resumed.
+template <typename T>
+struct WhenAnyState
+{
+    explicit WhenAnyState(std::vector<CoTask<T>> tasks) : tasks{std::move(tasks)}
+    {
+    }
+
+    // Called once by the winner and once by await_suspend, the second call resumes the awaiter.
+    void Release()
+    {
+        if (gate.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            awaiting.resume();
+    }
+
+    std::vector<CoTask<T>> tasks;
+    std::atomic_bool decided{false};
+    std::atomic_int gate{2};
+    std::size_t winner = 0;
+    std::coroutine_handle<> awaiting;
+};
+
+template <typename T>
+class WhenAnyAwaiter
+{
+public:
+    explicit WhenAnyAwaiter(std::shared_ptr<WhenAnyState<T>> state) : state{std::move(state)}
+    {
+    }
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        state->awaiting = handle;
+        for (std::size_t i = 0; i < state->tasks.size(); ++i)
+            Drive(state, i);
+
+        return state->gate.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+
+    void await_resume() const noexcept
+    {
+    }
+
+private:
+    static DetachedCoroutine Drive(std::shared_ptr<WhenAnyState<T>> state, std::size_t index)
+    {
+        co_await state->tasks[index].WhenReady();
+        if (!state->decided.exchange(true, std::memory_order_acq_rel))
+        {
+            state->winner = index;
+            state->Release();
+        }
+    }
+
+    std::shared_ptr<WhenAnyState<T>> state;
+};
+
+// Completes with the index (and result) of the first task to complete, rethrows its exception.
+// The other tasks run to completion in the background.
+template <typename T>
+CoTask<std::conditional_t<std::is_void_v<T>, std::size_t, std::pair<std::size_t, T>>> WhenAny(
+    std::vector<CoTask<T>> tasks)
+{
+    if (tasks.empty())
+        throw std::invalid_argument{"WhenAny needs at least one task"};
+
+    auto state = std::make_shared<WhenAnyState<T>>(std::move(tasks));
+    co_await WhenAnyAwaiter<T>{state};
+
+    auto& winner = state->tasks[state->winner];
+    if constexpr (std::is_void_v<T>)
+    {
+        co_await winner;
+        co_return state->winner;
+    }
+    else
+    {
+        co_return std::pair<std::size_t, T>{state->winner, co_await winner};
+    }
+}
+
+// Blocks the calling thread until the task completes and returns its result.
+// Must not be called from a pool worker that the task needs to make progress.
+template <typename T>
+T SyncWait(CoTask<T> task)
+{
+    struct State
+    {
+        std::optional<std::conditional_t<std::is_void_v<T>, std::monostate, T>> res;
+        std::exception_ptr error;
+        std::mutex mut;
+        std::condition_variable cv;
+        bool ready = false;
+    };
+
+    // Notifies under the lock, the waiter can't return and destroy the state before we're done with it.
+    const auto drive = [](CoTask<T>& task, State& state) -> DetachedCoroutine {
+        try
+        {
+            if constexpr (std::is_void_v<T>)
+            {
+                co_await task;
+                state.res.emplace();
+            }
+            else
+            {
+                state.res.emplace(co_await task);
+            }
+        }
+        catch (...)
+        {
+            state.error = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> lk{state.mut};
+        state.ready = true;
+        state.cv.notify_one();
+    };
+
+    State state;
+    drive(task, state);
+
+    {
+        std::unique_lock<std::mutex> lk{state.mut};
+        state.cv.wait(lk, [&state]() { return state.ready; });
+    }
+
+    if (state.error)
+        std::rethrow_exception(state.error);
+
+    if constexpr (!std::is_void_v<T>)
+        return std::move(*state.res);
+}
@@ -1,134 +1,99 @@
+#include "thread-pool.h"
+
+#include <sched.h>
 
 #include <atomic>
-#include <condition_variable>
-#include <functional>
+#include <chrono>
+#include <future>
 #include <iostream>
-#include <mutex>
-#include <new>
-#include <queue>
+#include <memory>
 #include <syncstream>
 #include <thread>
-#include <utility>
 #include <vector>
 
 using namespace std::literals;
 
-template <typename T>
-class ThreadSafeQueue
-{
-public:
-    [[nodiscard]] bool Empty() const
-    {
-        std::lock_guard<std::mutex> lk{mut};
-        return queue.empty();
-    }
-
-    void Push(T val)
-    {
-        {
-            std::lock_guard<std::mutex> lk{mut};
-            queue.push(std::move(val));
-        }
-        cvar.notify_one();
-    }
-
-    void WaitAndPop(T& val)
-    {
-        std::unique_lock<std::mutex> lk{mut};
-        cvar.wait(lk, [this]() { return !queue.empty(); });
-        val = std::move(queue.front());
-        queue.pop();
-    }
-
-    bool TryPop(T& val)
-    {
-        std::lock_guard<std::mutex> lk{mut};
-        if (queue.empty())
-            return false;
-
-        val = std::move(queue.front());
-        queue.pop();
-        return true;
-    }
-
-private:
-    mutable std::mutex mut;
-    std::queue<T> queue;
-    std::condition_variable cvar;
-};
-
-class ThreadPool
-{
-public:
-    ThreadPool() : threadCount{std::thread::hardware_concurrency()}, done{false}
-    {
-        try
-        {
-            for (unsigned i = 0; i < threadCount; ++i)
-                threads.emplace_back(&ThreadPool::DoWork, this);
-        }
-        catch (...)
-        {
-            Cleanup();
-            throw;
-        }
-    }
-
-    ~ThreadPool()
-    {
-        Cleanup();
-    }
-
-    [[nodiscard]] size_t Size() const
-    {
-        return threadCount;
-    }
-
-    template <typename CallableType>
-    void Submit(CallableType callable)
-    {
-        workQueue.Push(std::function<void()>{callable});
-    }
-
-private:
-    void Cleanup()
-    {
-        done = true;
-        for (auto& t : threads)
-            if (t.joinable())
-                t.join();
-    }
-
-    void DoWork()
-    {
-        while (!done)
-        {
-            std::function<void()> task;
-            if (workQueue.TryPop(task))
-                task();
-            else
-                std::this_thread::yield();
-        }
-    }
-
-    // Order matters:
-    // - Destroy threads -> queue
-    size_t threadCount;
-    std::atomic_bool done;
-    ThreadSafeQueue<std::function<void()>> workQueue;
-    std::vector<std::thread> threads;
-};
-
 int main()
 {
     ThreadPool threadPool;
     std::cout << "ThreadPool has " << threadPool.Size() << " threads\n";
 
     for (size_t i = 0; i < threadPool.Size(); ++i)
-        threadPool.Submit(
+        threadPool.Post(
             [i]() { std::osyncstream{std::cout} << std::this_thread::get_id() << " says " << i << '\n'; });
 
+    // Fan-out: tasks submitted from a worker land in its local queue and idle workers steal them.
+    std::atomic_int leaves{0};
+    threadPool.Post([&]() {
+        for (int i = 0; i < 16; ++i)
+            threadPool.Post([&leaves, i]() {
+                std::osyncstream{std::cout} << std::this_thread::get_id() << " runs child " << i << '\n';
+                ++leaves;
+            });
+    });
+
+    // Move-only callables and results.
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 4; ++i)
+        results.emplace_back(threadPool.Submit([val = std::make_unique<int>(i)]() { return *val * *val; }));
+
+    for (auto& res : results)
+        std::cout << "Result: " << res.get() << '\n';
+
+    // Bulk submission, both calls block until all of the work is done.
+    std::vector<int> squares(1000);
+    threadPool.ParallelFor(0, static_cast<int>(squares.size()), 64, [&](int i) { squares[i] = i * i; });
+    std::cout << "ParallelFor: squares[999] = " << squares[999] << '\n';
+
+    std::atomic_int batchSum{0};
+    std::vector<Task> batch;
+    for (int i = 1; i <= 10; ++i)
+        batch.emplace_back([&batchSum, i]() { batchSum += i; });
+    threadPool.SubmitBatch(batch);
+    std::cout << "SubmitBatch: sum = " << batchSum << '\n';
+
+    // Priority lanes: a latency-critical task overtakes a backlog of background work.
+    for (int i = 0; i < 100; ++i)
+        threadPool.Post(Priority::Low, []() { std::this_thread::sleep_for(10ms); });
+    std::cout << "Low lane depth: " << threadPool.QueueDepth(Priority::Low) << '\n';
+
+    const auto submitted = ThreadPool::Clock::now();
+    auto waited = threadPool.Submit(Priority::High, [submitted]() { return ThreadPool::Clock::now() - submitted; });
+    std::cout << "High priority task waited "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(waited.get()).count() << "ms\n";
+
+    // Explicit size and one sub-pool per NUMA node, workers pinned to the CPUs of their node.
+    for (const auto& node : ReadNumaTopology())
+        std::cout << "NUMA node " << node.id << ": " << node.cpus.size() << " CPUs\n";
+
+    ThreadPool numaPool{ThreadPoolOptions{.threadCount = 4, .numaAware = true}};
+    std::cout << "NUMA pool has " << numaPool.Size() << " threads on " << numaPool.NodeCount() << " nodes\n";
+    for (size_t node = 0; node < numaPool.NodeCount(); ++node)
+    {
+        auto res = numaPool.SubmitToNode(node, [node]() {
+            std::osyncstream{std::cout} << "Task for node " << node << " runs on CPU " << sched_getcpu() << '\n';
+        });
+        res.get();
+    }
+
     std::this_thread::sleep_for(3s);
+    std::cout << "Children executed: " << leaves << '\n';
+
+    const auto toMs = [](std::chrono::nanoseconds ns) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(ns);
+    };
+    const auto stats = threadPool.Stats();
+    for (size_t i = 0; i < stats.size(); ++i)
+    {
+        const auto& s = stats[i];
+        std::cout << "Worker " << i << ": " << s.tasksExecuted << " tasks, busy " << toMs(s.busy).count() << "ms, idle "
+                  << toMs(s.idle).count() << "ms, " << s.failedPops << " failed pops, queue high-water "
+                  << s.queueHighWater << "\n  queue wait histogram:";
+        for (size_t bucket = 0; bucket < s.waitHistogram.size(); ++bucket)
+            if (s.waitHistogram[bucket] != 0)
+                std::cout << " <" << (1ULL << bucket) << "ns:" << s.waitHistogram[bucket];
+        std::cout << '\n';
+    }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,1093 @@
+#pragma once
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <concepts>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "cpu.h"
+
+// Move-only type-erased callable.
+// Unlike std::function it accepts move-only callables (lambdas capturing a unique_ptr or a
+// promise) and stores captures that fit in the inline buffer without allocating.
+// The whole object fills exactly one cache line.
+class Task
+{
+public:
+    static constexpr std::size_t kSize = 64;
+
+    Task() = default;
+
+    template <typename CallableType>
+        requires(!std::is_same_v<std::decay_t<CallableType>, Task> && std::is_invocable_v<std::decay_t<CallableType>&>)
+    Task(CallableType&& callable) // NOLINT(google-explicit-constructor)
+    {
+        using Fn = std::decay_t<CallableType>;
+        if constexpr (kFitsInline<Fn>)
+        {
+            ::new (static_cast<void*>(storage)) Fn(std::forward<CallableType>(callable));
+            ops = &kInlineOps<Fn>;
+        }
+        else
+        {
+            ::new (static_cast<void*>(storage)) Fn*(new Fn(std::forward<CallableType>(callable)));
+            ops = &kHeapOps<Fn>;
+        }
+    }
+
+    Task(Task&& other) noexcept : ops{std::exchange(other.ops, nullptr)}
+    {
+        if (ops)
+            ops->move(storage, other.storage);
+    }
+
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Reset();
+            ops = std::exchange(other.ops, nullptr);
+            if (ops)
+                ops->move(storage, other.storage);
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task()
+    {
+        Reset();
+    }
+
+    void operator()()
+    {
+        ops->invoke(storage);
+    }
+
+    explicit operator bool() const
+    {
+        return ops != nullptr;
+    }
+
+private:
+    // move() leaves the source destroyed, so a moved-from Task only needs ops cleared.
+    struct Ops
+    {
+        void (*invoke)(void* self);
+        void (*move)(void* dst, void* src) noexcept;
+        void (*destroy)(void* self) noexcept;
+    };
+
+    static constexpr std::size_t kInlineSize = kSize - sizeof(const Ops*);
+
+    template <typename Fn>
+    static constexpr bool kFitsInline = sizeof(Fn) <= kInlineSize && alignof(Fn) <= alignof(std::max_align_t) &&
+                                        std::is_nothrow_move_constructible_v<Fn>;
+
+    template <typename Fn>
+    static constexpr Ops kInlineOps{
+        [](void* self) { (*static_cast<Fn*>(self))(); },
+        [](void* dst, void* src) noexcept {
+            ::new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        },
+        [](void* self) noexcept { static_cast<Fn*>(self)->~Fn(); },
+    };
+
+    template <typename Fn>
+    static constexpr Ops kHeapOps{
+        [](void* self) { (**static_cast<Fn**>(self))(); },
+        [](void* dst, void* src) noexcept { ::new (dst) Fn*(*static_cast<Fn**>(src)); },
+        [](void* self) noexcept { delete *static_cast<Fn**>(self); },
+    };
+
+    void Reset()
+    {
+        if (ops)
+            std::exchange(ops, nullptr)->destroy(storage);
+    }
+
+    alignas(std::max_align_t) std::byte storage[kInlineSize];
+    const Ops* ops = nullptr;
+};
+
+static_assert(sizeof(Task) == Task::kSize);
+
+enum class Priority : std::uint8_t
+{
+    High,
+    Normal,
+    Low,
+};
+
+inline constexpr std::size_t kPriorityCount = 3;
+
+// Multi-lane queue, one lane per priority.
+// - Pop serves the highest non-empty lane.
+// - Within a lane entries are ordered by deadline. Entries without an explicit deadline get
+//   enqueue time + the lane's aging limit, which keeps them in FIFO order.
+// - Once a lane head is past its deadline it's served ahead of the lane order (earliest deadline
+//   first among the overdue heads). A flood of high priority entries delays a lower lane by at
+//   most its aging limit.
+template <typename T>
+class PriorityLaneQueue
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using AgingLimits = std::array<Clock::duration, kPriorityCount>;
+
+    static constexpr AgingLimits kDefaultAgingLimits{std::chrono::milliseconds{1}, std::chrono::milliseconds{10},
+                                                     std::chrono::milliseconds{100}};
+
+    explicit PriorityLaneQueue(AgingLimits agingLimits = kDefaultAgingLimits) : agingLimits{agingLimits}
+    {
+    }
+
+    [[nodiscard]] bool Empty() const
+    {
+        std::lock_guard<std::mutex> lk{mut};
+        return std::ranges::all_of(lanes, [](const Lane& lane) { return lane.heap.empty(); });
+    }
+
+    // Number of queued entries in a lane, doesn't take the lock.
+    [[nodiscard]] size_t Depth(Priority priority) const
+    {
+        return lanes[Index(priority)].depth.load(std::memory_order_relaxed);
+    }
+
+    void Push(T val, Priority priority = Priority::Normal, std::optional<Clock::time_point> deadline = std::nullopt)
+    {
+        const auto now = Clock::now();
+        std::lock_guard<std::mutex> lk{mut};
+        PushLocked(std::move(val), priority, deadline, now);
+    }
+
+    // Moves all values in under a single lock acquisition.
+    void PushBulk(std::span<T> vals, Priority priority = Priority::Normal)
+    {
+        const auto now = Clock::now();
+        std::lock_guard<std::mutex> lk{mut};
+        for (auto& val : vals)
+            PushLocked(std::move(val), priority, std::nullopt, now);
+    }
+
+    bool TryPop(T& val)
+    {
+        std::lock_guard<std::mutex> lk{mut};
+
+        Lane* next = nullptr;
+        size_t nonEmpty = 0;
+        for (auto& lane : lanes)
+        {
+            if (lane.heap.empty())
+                continue;
+
+            if (!next)
+                next = &lane;
+            ++nonEmpty;
+        }
+
+        if (!next)
+            return false;
+
+        // Aging only matters when there is more than one lane to choose from.
+        if (nonEmpty > 1)
+        {
+            const auto now = Clock::now();
+            Lane* overdue = nullptr;
+            for (auto& lane : lanes)
+            {
+                if (lane.heap.empty() || lane.heap.front().deadline > now)
+                    continue;
+
+                if (!overdue || lane.heap.front().deadline < overdue->heap.front().deadline)
+                    overdue = &lane;
+            }
+
+            if (overdue)
+                next = overdue;
+        }
+
+        std::ranges::pop_heap(next->heap, Later{});
+        val = std::move(next->heap.back().val);
+        next->heap.pop_back();
+        next->depth.store(next->heap.size(), std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    struct Entry
+    {
+        Clock::time_point deadline;
+        std::uint64_t seq;
+        T val;
+    };
+
+    // Heap order, the front is the entry with the earliest deadline.
+    struct Later
+    {
+        bool operator()(const Entry& lhs, const Entry& rhs) const
+        {
+            return std::tie(lhs.deadline, lhs.seq) > std::tie(rhs.deadline, rhs.seq);
+        }
+    };
+
+    struct Lane
+    {
+        std::vector<Entry> heap;
+        std::atomic_size_t depth{0};
+    };
+
+    static constexpr size_t Index(Priority priority)
+    {
+        return static_cast<size_t>(priority);
+    }
+
+    void PushLocked(T val, Priority priority, std::optional<Clock::time_point> deadline, Clock::time_point now)
+    {
+        auto& lane = lanes[Index(priority)];
+        const auto agedDeadline = now + agingLimits[Index(priority)];
+        const auto effectiveDeadline = deadline ? std::min(*deadline, agedDeadline) : agedDeadline;
+        lane.heap.push_back(Entry{effectiveDeadline, nextSeq++, std::move(val)});
+        std::ranges::push_heap(lane.heap, Later{});
+        lane.depth.store(lane.heap.size(), std::memory_order_relaxed);
+    }
+
+    AgingLimits agingLimits;
+    mutable std::mutex mut;
+    std::array<Lane, kPriorityCount> lanes;
+    std::uint64_t nextSeq = 0;
+};
+
+// Per-worker deque. The owner pushes and pops at the front (LIFO keeps the most recently
+// spawned, cache-hot work local), thieves take from the back (the oldest and usually the
+// biggest chunks of work).
+// Lock-based instead of Chase-Lev because the elements aren't trivially copyable, but the
+// lock is private to one worker and only contended while somebody is stealing.
+template <typename T>
+class WorkStealingQueue
+{
+public:
+    [[nodiscard]] bool Empty() const
+    {
+        std::lock_guard<std::mutex> lk{mut};
+        return queue.empty();
+    }
+
+    // Both pushes return the queue depth after the push.
+    size_t Push(T val)
+    {
+        std::lock_guard<std::mutex> lk{mut};
+        queue.push_front(std::move(val));
+        return queue.size();
+    }
+
+    size_t PushBulk(std::span<T> vals)
+    {
+        std::lock_guard<std::mutex> lk{mut};
+        for (auto& val : vals)
+            queue.push_front(std::move(val));
+        return queue.size();
+    }
+
+    bool TryPop(T& val)
+    {
+        std::lock_guard<std::mutex> lk{mut};
+        if (queue.empty())
+            return false;
+
+        val = std::move(queue.front());
+        queue.pop_front();
+        return true;
+    }
+
+    bool TrySteal(T& val)
+    {
+        std::lock_guard<std::mutex> lk{mut};
+        if (queue.empty())
+            return false;
+
+        val = std::move(queue.back());
+        queue.pop_back();
+        return true;
+    }
+
+private:
+    mutable std::mutex mut;
+    std::deque<T> queue;
+};
+
+// Per-worker statistics are compiled in unless THREAD_POOL_STATS is defined to 0.
+#ifndef THREAD_POOL_STATS
+#define THREAD_POOL_STATS 1
+#endif
+
+// Snapshot of one worker's counters.
+// waitHistogram[i] counts tasks that waited in a queue (from submit until the start of execution)
+// for [2^(i-1), 2^i) ns, waitHistogram[0] those that didn't wait at all.
+struct WorkerStats
+{
+    static constexpr size_t kWaitBuckets = 40;
+
+    std::uint64_t tasksExecuted = 0;
+    std::chrono::nanoseconds busy{0};
+    std::chrono::nanoseconds idle{0};
+    std::uint64_t failedPops = 0;
+    std::size_t queueHighWater = 0;
+    std::array<std::uint64_t, kWaitBuckets> waitHistogram{};
+};
+
+// What the pool queues hold: the task plus, with stats enabled, the time it was submitted.
+struct PoolTask
+{
+    Task task;
+#if THREAD_POOL_STATS
+    std::chrono::steady_clock::time_point submitted{};
+#endif
+};
+
+// Only the submit path stamps the time, placeholder PoolTasks in the worker loop don't call now().
+inline PoolTask MakePoolTask(Task task)
+{
+#if THREAD_POOL_STATS
+    return PoolTask{std::move(task), std::chrono::steady_clock::now()};
+#else
+    return PoolTask{std::move(task)};
+#endif
+}
+
+// NUMA node as described by /sys/devices/system/node/node<N>/cpulist.
+struct NumaNode
+{
+    int id = 0;
+    std::vector<int> cpus;
+};
+
+// Parses a kernel CPU list such as "0-3,8-11".
+inline std::vector<int> ParseCpuList(std::string_view list)
+{
+    std::vector<int> cpus;
+    while (!list.empty())
+    {
+        const auto comma = list.find(',');
+        const auto range = list.substr(0, comma);
+        list = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+
+        int first = 0;
+        const auto [ptr, ec] = std::from_chars(range.data(), range.data() + range.size(), first);
+        if (ec != std::errc{})
+            continue;
+
+        int last = first;
+        if (ptr != range.data() + range.size() && *ptr == '-')
+            std::from_chars(ptr + 1, range.data() + range.size(), last);
+
+        for (int cpu = first; cpu <= last; ++cpu)
+            cpus.push_back(cpu);
+    }
+
+    return cpus;
+}
+
+// Nodes with at least one CPU, ordered by id.
+// Falls back to a single node with every CPU when the sysfs topology isn't available.
+inline std::vector<NumaNode> ReadNumaTopology()
+{
+    std::vector<NumaNode> nodes;
+
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator{"/sys/devices/system/node", ec})
+    {
+        const auto name = entry.path().filename().string();
+        int id = 0;
+        if (!name.starts_with("node") ||
+            std::from_chars(name.data() + 4, name.data() + name.size(), id).ptr != name.data() + name.size())
+            continue;
+
+        std::ifstream file{entry.path() / "cpulist"};
+        std::string list;
+        std::getline(file, list);
+
+        // Memory-only nodes have no CPUs to run workers on.
+        auto cpus = ParseCpuList(list);
+        if (!cpus.empty())
+            nodes.push_back(NumaNode{id, std::move(cpus)});
+    }
+
+    if (nodes.empty())
+    {
+        NumaNode node;
+        for (unsigned cpu = 0; cpu < std::max(1U, std::thread::hardware_concurrency()); ++cpu)
+            node.cpus.push_back(static_cast<int>(cpu));
+        nodes.push_back(std::move(node));
+    }
+
+    std::ranges::sort(nodes, {}, &NumaNode::id);
+    return nodes;
+}
+
+// threadCount: number of workers, 0 starts one per CPU.
+// workerCpus: workerCpus[i] is the set of CPUs worker i is pinned to. Workers without a set
+// aren't pinned (unless numaAware).
+// numaAware: one sub-pool per NUMA node. Workers are spread round-robin over the nodes and pinned
+// to the CPUs of their node, every node has its own shared queue and tasks submitted from outside
+// the pool go to the queue of the node the submitting thread runs on.
+// spinCount, yieldCount, park: an idle worker spins for spinCount rounds, yields for yieldCount
+// rounds and then parks until new work is posted. With park == false it keeps yielding forever.
+// agingLimits: bound how long a task waits in a shared queue before it's served ahead of higher
+// priority lanes.
+struct ThreadPoolOptions
+{
+    size_t threadCount = 0;
+    std::vector<std::vector<int>> workerCpus{};
+    bool numaAware = false;
+    unsigned spinCount = 256;
+    unsigned yieldCount = 16;
+    bool park = true;
+    PriorityLaneQueue<PoolTask>::AgingLimits agingLimits = PriorityLaneQueue<PoolTask>::kDefaultAgingLimits;
+};
+
+// Work-stealing thread pool made of one sub-pool per NUMA node (a single one unless numaAware):
+// - Tasks submitted from outside the pool go to the Normal lane of the caller's node queue.
+// - Tasks submitted from a worker go to that worker's local queue.
+// - Tasks submitted with a priority (and optionally a deadline) always go to a node queue.
+// - A worker runs High lane tasks first, then local tasks, then tasks from its node queue, then
+//   steals from a random victim on its node and only then from other nodes.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(ThreadPoolOptions options = {}) : options{options}, done{false}
+    {
+        const auto topology = options.numaAware ? ReadNumaTopology() : std::vector<NumaNode>{};
+
+        threadCount = options.threadCount;
+        if (threadCount == 0)
+            threadCount = options.numaAware ? std::transform_reduce(topology.begin(), topology.end(), size_t{0},
+                                                                    std::plus<>{},
+                                                                    [](const NumaNode& n) { return n.cpus.size(); })
+                                            : std::max(1U, std::thread::hardware_concurrency());
+
+        try
+        {
+            const auto nodeCount = std::max<size_t>(1, topology.size());
+            for (size_t node = 0; node < nodeCount; ++node)
+                nodes.emplace_back(std::make_unique<NodePool>(options.agingLimits));
+
+            for (size_t node = 0; node < topology.size(); ++node)
+                for (const int cpu : topology[node].cpus)
+                {
+                    if (static_cast<size_t>(cpu) >= cpuNode.size())
+                        cpuNode.resize(cpu + 1, 0);
+                    cpuNode[cpu] = node;
+                }
+
+#if THREAD_POOL_STATS
+            counters = std::vector<WorkerCounters>(threadCount);
+#endif
+
+            localQueues.reserve(threadCount);
+            for (size_t i = 0; i < threadCount; ++i)
+            {
+                localQueues.emplace_back(std::make_unique<WorkStealingQueue<PoolTask>>());
+                workerNode.push_back(i % nodeCount);
+                nodes[i % nodeCount]->workers.push_back(i);
+            }
+
+            for (size_t i = 0; i < threadCount; ++i)
+            {
+                threads.emplace_back(&ThreadPool::DoWork, this, i);
+
+                if (i < options.workerCpus.size() && !options.workerCpus[i].empty())
+                    Pin(threads.back(), options.workerCpus[i]);
+                else if (options.numaAware)
+                    Pin(threads.back(), topology[workerNode[i]].cpus);
+            }
+        }
+        catch (...)
+        {
+            Cleanup();
+            throw;
+        }
+    }
+
+    // Tasks still queued are dropped without running.
+    ~ThreadPool()
+    {
+        Cleanup();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    [[nodiscard]] size_t Size() const
+    {
+        return threadCount;
+    }
+
+    using Clock = PriorityLaneQueue<PoolTask>::Clock;
+
+    [[nodiscard]] size_t NodeCount() const
+    {
+        return nodes.size();
+    }
+
+    // Number of tasks waiting in a lane of the node queues.
+    [[nodiscard]] size_t QueueDepth(Priority priority) const
+    {
+        size_t depth = 0;
+        for (const auto& node : nodes)
+            depth += node->queue.Depth(priority);
+        return depth;
+    }
+
+    // Returns a future for the callable's result.
+    // The shared state of the future is the only allocation, use Post() when the result isn't needed.
+    template <typename CallableType>
+    std::future<std::invoke_result_t<CallableType&>> Submit(CallableType callable)
+    {
+        auto [task, res] = Package(std::move(callable));
+        Post(std::move(task));
+        return std::move(res);
+    }
+
+    template <typename CallableType>
+    std::future<std::invoke_result_t<CallableType&>> Submit(Priority priority, CallableType callable)
+    {
+        auto [task, res] = Package(std::move(callable));
+        Post(priority, std::move(task));
+        return std::move(res);
+    }
+
+    template <typename CallableType>
+    std::future<std::invoke_result_t<CallableType&>> Submit(Priority priority, Clock::time_point deadline,
+                                                            CallableType callable)
+    {
+        auto [task, res] = Package(std::move(callable));
+        Post(priority, deadline, std::move(task));
+        return std::move(res);
+    }
+
+    // Runs on a worker of the given node, e.g. next to the memory the task works on.
+    template <typename CallableType>
+    std::future<std::invoke_result_t<CallableType&>> SubmitToNode(size_t node, CallableType callable)
+    {
+        auto [task, res] = Package(std::move(callable));
+        PostToNode(node, std::move(task));
+        return std::move(res);
+    }
+
+    // Fire and forget, doesn't allocate when the callable fits in a Task.
+    template <typename CallableType>
+    void Post(CallableType callable)
+    {
+        if (localPool == this)
+            PushLocal(MakePoolTask(Task{std::move(callable)}));
+        else
+            nodes[CurrentNode()]->queue.Push(MakePoolTask(Task{std::move(callable)}));
+
+        WakeOne();
+    }
+
+    template <typename CallableType>
+    void Post(Priority priority, CallableType callable)
+    {
+        nodes[CurrentNode()]->queue.Push(MakePoolTask(Task{std::move(callable)}), priority);
+        WakeOne();
+    }
+
+    // The deadline moves the task ahead of older tasks in its lane and, once it has passed, ahead
+    // of higher lanes.
+    template <typename CallableType>
+    void Post(Priority priority, Clock::time_point deadline, CallableType callable)
+    {
+        nodes[CurrentNode()]->queue.Push(MakePoolTask(Task{std::move(callable)}), priority, deadline);
+        WakeOne();
+    }
+
+    template <typename CallableType>
+    void PostToNode(size_t node, CallableType callable)
+    {
+        nodes[node % nodes.size()]->queue.Push(MakePoolTask(Task{std::move(callable)}));
+        WakeOne();
+    }
+
+    // Runs all tasks and returns once every one of them has completed, the calling thread helps.
+    // The tasks are enqueued under a single lock acquisition. Rethrows the first exception thrown
+    // by a task.
+    void SubmitBatch(std::span<Task> tasks)
+    {
+        BulkState state{tasks.size()};
+
+        // Runners only point into the caller's span so they always fit in a Task without allocating.
+        std::vector<PoolTask> runners;
+        runners.reserve(tasks.size());
+        for (auto& task : tasks)
+            runners.emplace_back(MakePoolTask(Task{[&task, &state]() {
+                state.Run(task);
+                state.Done(1);
+            }}));
+
+        if (localPool == this)
+            PushLocal(runners);
+        else
+            nodes[CurrentNode()]->queue.PushBulk(runners);
+
+        Wake(runners.size());
+        WaitFor(state);
+    }
+
+    // Calls fn(i) for every i in [begin, end) and returns once all calls have completed, the calling
+    // thread helps. The range is split lazily: a task halves its range, posts the upper half where an
+    // idle worker can steal it and keeps going until at most grain indices are left.
+    // Rethrows the first exception thrown by fn, the rest of the failing chunk is skipped.
+    template <std::integral IndexType, typename Fn>
+        requires std::invocable<Fn&, IndexType>
+    void ParallelFor(IndexType begin, IndexType end, IndexType grain, Fn fn)
+    {
+        if (begin >= end)
+            return;
+
+        BulkState state{static_cast<size_t>(end - begin)};
+        RunRange(begin, end, std::max<IndexType>(grain, 1), fn, state);
+        WaitFor(state);
+    }
+
+    // co_await pool.Schedule() suspends the coroutine and resumes it on a pool worker.
+    // The pool doesn't own the frame: one still queued when the pool is destroyed is never resumed nor
+    // destroyed, so wait for every scheduled coroutine (e.g. SyncWait) before destroying the pool.
+    [[nodiscard]] auto Schedule()
+    {
+        struct Awaiter
+        {
+            bool await_ready() const noexcept
+            {
+                return false;
+            }
+
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                pool.Post([handle]() { handle.resume(); });
+            }
+
+            void await_resume() const noexcept
+            {
+            }
+
+            ThreadPool& pool;
+        };
+
+        return Awaiter{*this};
+    }
+
+    // Runs one pending task on the calling thread, useful for threads that wait on pool work.
+    bool RunPendingTask()
+    {
+        auto& home = *nodes[CurrentNode()];
+
+        PoolTask task;
+        if (!PopUrgentTask(home, task) && !PopLocalTask(task) && !home.queue.TryPop(task) && !StealTask(home, task))
+            return false;
+
+        Run(task);
+        return true;
+    }
+
+    // Per-worker counters, empty when stats are compiled out.
+    // Counters are read without synchronizing with the workers, so the values of one worker
+    // may be a few tasks apart from each other.
+    [[nodiscard]] std::vector<WorkerStats> Stats() const
+    {
+        std::vector<WorkerStats> res;
+#if THREAD_POOL_STATS
+        const auto uptime = Clock::now() - started;
+        res.reserve(counters.size());
+        for (const auto& c : counters)
+        {
+            auto& stats = res.emplace_back();
+            stats.tasksExecuted = c.tasksExecuted.load(std::memory_order_relaxed);
+            stats.busy = std::chrono::nanoseconds{c.busyNs.load(std::memory_order_relaxed)};
+            stats.idle = std::max(std::chrono::nanoseconds{0}, uptime - stats.busy);
+            stats.failedPops = c.failedPops.load(std::memory_order_relaxed);
+            stats.queueHighWater = c.queueHighWater.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < WorkerStats::kWaitBuckets; ++i)
+                stats.waitHistogram[i] = c.waitHistogram[i].load(std::memory_order_relaxed);
+        }
+#endif
+        return res;
+    }
+
+private:
+    // The shared queue of a NUMA node and the workers that run on it.
+    struct NodePool
+    {
+        explicit NodePool(PriorityLaneQueue<PoolTask>::AgingLimits agingLimits) : queue{agingLimits}
+        {
+        }
+
+        PriorityLaneQueue<PoolTask> queue;
+        std::vector<size_t> workers;
+    };
+
+#if THREAD_POOL_STATS
+    // Written only by the owning worker, padded so workers don't share cache lines.
+    struct alignas(kNoSharing) WorkerCounters
+    {
+        std::atomic_uint64_t tasksExecuted{0};
+        std::atomic_uint64_t busyNs{0};
+        std::atomic_uint64_t failedPops{0};
+        std::atomic_size_t queueHighWater{0};
+        std::array<std::atomic_uint64_t, WorkerStats::kWaitBuckets> waitHistogram{};
+    };
+
+    // Single writer, a plain load + store is enough and avoids a locked instruction.
+    template <typename T>
+    static void Bump(std::atomic<T>& counter, T value = 1)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+#endif
+
+    static void Pin(std::thread& thread, const std::vector<int>& cpus)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (const int cpu : cpus)
+        {
+            if (cpu < 0 || cpu >= CPU_SETSIZE)
+                throw std::system_error{EINVAL, std::system_category(), "pthread_setaffinity_np"};
+            CPU_SET(cpu, &set);
+        }
+
+        const int err = pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+        if (err != 0)
+            throw std::system_error{err, std::system_category(), "pthread_setaffinity_np"};
+    }
+
+    // Node of the calling thread: the worker's own node or the node of the CPU we're running on.
+    [[nodiscard]] size_t CurrentNode() const
+    {
+        if (localPool == this)
+            return workerNode[localIndex];
+
+        if (nodes.size() == 1)
+            return 0;
+
+        const int cpu = sched_getcpu();
+        return cpu >= 0 && static_cast<size_t>(cpu) < cpuNode.size() ? cpuNode[cpu] : 0;
+    }
+
+    template <typename TaskType>
+    void PushLocal(TaskType&& task)
+    {
+        size_t depth = 0;
+        if constexpr (std::is_same_v<std::decay_t<TaskType>, PoolTask>)
+            depth = localQueues[localIndex]->Push(std::forward<TaskType>(task));
+        else
+            depth = localQueues[localIndex]->PushBulk(task);
+
+#if THREAD_POOL_STATS
+        auto& highWater = counters[localIndex].queueHighWater;
+        if (depth > highWater.load(std::memory_order_relaxed))
+            highWater.store(depth, std::memory_order_relaxed);
+#else
+        (void)depth;
+#endif
+    }
+
+    // Tasks run by a worker while it waits inside another task (nested ParallelFor) are counted but
+    // their time is already part of the outer task.
+    void Run(PoolTask& task)
+    {
+#if THREAD_POOL_STATS
+        if (localPool == this && runDepth == 0)
+        {
+            auto& c = counters[localIndex];
+            const auto start = Clock::now();
+            const auto waitNs = std::chrono::duration_cast<std::chrono::nanoseconds>(start - task.submitted);
+            const auto bucket = std::bit_width(static_cast<std::uint64_t>(std::max<std::int64_t>(waitNs.count(), 0)));
+            Bump(c.waitHistogram[std::min<size_t>(bucket, WorkerStats::kWaitBuckets - 1)]);
+
+            ++runDepth;
+            task.task();
+            --runDepth;
+
+            const auto busy = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+            Bump<std::uint64_t>(c.busyNs, busy.count());
+            Bump(c.tasksExecuted);
+            return;
+        }
+
+        if (localPool == this)
+            Bump(counters[localIndex].tasksExecuted);
+#endif
+        task.task();
+    }
+
+    template <typename CallableType>
+    static auto Package(CallableType callable)
+    {
+        std::packaged_task<std::invoke_result_t<CallableType&>()> task{std::move(callable)};
+        auto res = task.get_future();
+        return std::pair{std::move(task), std::move(res)};
+    }
+
+    // Completion tracking for the blocking bulk operations.
+    // Done() must be the last access of a task to the state, the waiter may return right after.
+    struct BulkState
+    {
+        explicit BulkState(size_t pending) : pending{pending}
+        {
+        }
+
+        template <typename Fn>
+        void Run(Fn&& fn)
+        {
+            try
+            {
+                fn();
+            }
+            catch (...)
+            {
+                if (!failed.test_and_set(std::memory_order_relaxed))
+                    error = std::current_exception();
+            }
+        }
+
+        void Done(size_t count)
+        {
+            pending.fetch_sub(count, std::memory_order_release);
+        }
+
+        std::atomic_size_t pending;
+        std::atomic_flag failed;
+        std::exception_ptr error;
+    };
+
+    template <typename IndexType, typename Fn>
+    void RunRange(IndexType first, IndexType last, IndexType grain, Fn& fn, BulkState& state)
+    {
+        while (last - first > grain)
+        {
+            const IndexType mid = first + (last - first) / 2;
+            Post([this, mid, last, grain, &fn, &state]() { RunRange(mid, last, grain, fn, state); });
+            last = mid;
+        }
+
+        state.Run([&]() {
+            for (auto i = first; i < last; ++i)
+                fn(i);
+        });
+        state.Done(static_cast<size_t>(last - first));
+    }
+
+    void WaitFor(BulkState& state)
+    {
+        while (state.pending.load(std::memory_order_acquire) != 0)
+            if (!RunPendingTask())
+                std::this_thread::yield();
+
+        if (state.error)
+            std::rethrow_exception(state.error);
+    }
+
+    void Cleanup()
+    {
+        done = true;
+        wakeEpoch.fetch_add(1, std::memory_order_release);
+        wakeEpoch.notify_all();
+
+        for (auto& t : threads)
+            if (t.joinable())
+                t.join();
+    }
+
+    void DoWork(size_t index)
+    {
+        localPool = this;
+        localIndex = index;
+        localRng.seed(index + 1);
+
+        unsigned idleRounds = 0;
+        while (!done)
+        {
+            if (RunPendingTask())
+            {
+                idleRounds = 0;
+            }
+            else
+            {
+#if THREAD_POOL_STATS
+                Bump(counters[index].failedPops);
+#endif
+                Idle(idleRounds);
+            }
+        }
+    }
+
+    void Idle(unsigned& idleRounds)
+    {
+        if (idleRounds < options.spinCount)
+        {
+            ++idleRounds;
+            CpuRelax();
+        }
+        else if (idleRounds < options.spinCount + options.yieldCount || !options.park)
+        {
+            ++idleRounds;
+            std::this_thread::yield();
+        }
+        else
+        {
+            idleRounds = 0;
+            Park();
+        }
+    }
+
+    // Sleeps until WakeOne() bumps the epoch.
+    // The worker announces itself in sleepers before the final check of the queues. Either the check
+    // sees a task pushed concurrently or the pusher (whose push is ordered after our check through
+    // the queue mutex) sees sleepers > 0 and bumps the epoch, so a wake-up can't get lost.
+    void Park()
+    {
+        const auto epoch = wakeEpoch.load(std::memory_order_acquire);
+        sleepers.fetch_add(1, std::memory_order_seq_cst);
+
+        if (!done && !HasPendingTask())
+            wakeEpoch.wait(epoch, std::memory_order_acquire);
+
+        sleepers.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void WakeOne()
+    {
+        Wake(1);
+    }
+
+    void Wake(size_t count)
+    {
+        const auto sleeping = sleepers.load(std::memory_order_seq_cst);
+        if (sleeping == 0 || count == 0)
+            return;
+
+        wakeEpoch.fetch_add(1, std::memory_order_release);
+        if (count >= sleeping)
+            wakeEpoch.notify_all();
+        else
+            for (size_t i = 0; i < count; ++i)
+                wakeEpoch.notify_one();
+    }
+
+    [[nodiscard]] bool HasPendingTask() const
+    {
+        for (const auto& node : nodes)
+            if (!node->queue.Empty())
+                return true;
+
+        for (const auto& queue : localQueues)
+            if (!queue->Empty())
+                return true;
+
+        return false;
+    }
+
+    // Latency-critical work shouldn't wait until the local queue is drained.
+    static bool PopUrgentTask(NodePool& home, PoolTask& task)
+    {
+        return home.queue.Depth(Priority::High) > 0 && home.queue.TryPop(task);
+    }
+
+    bool PopLocalTask(PoolTask& task)
+    {
+        return localPool == this && localQueues[localIndex]->TryPop(task);
+    }
+
+    // Starts at a random victim so idle workers don't all hammer the same queue.
+    // Other nodes are only visited once there is nothing left to steal on the home node.
+    bool StealTask(NodePool& home, PoolTask& task)
+    {
+        if (StealFromNode(home, task))
+            return true;
+
+        for (auto& node : nodes)
+            if (node.get() != &home && (node->queue.TryPop(task) || StealFromNode(*node, task)))
+                return true;
+
+        return false;
+    }
+
+    bool StealFromNode(NodePool& node, PoolTask& task)
+    {
+        const auto count = node.workers.size();
+        if (count == 0)
+            return false;
+
+        const auto start = std::uniform_int_distribution<size_t>{0, count - 1}(localRng);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const auto victim = node.workers[(start + i) % count];
+            if (localPool == this && victim == localIndex)
+                continue;
+
+            if (localQueues[victim]->TrySteal(task))
+                return true;
+        }
+
+        return false;
+    }
+
+    // Identifies the pool and queue of a worker thread, nullptr for threads outside of any pool.
+    static inline thread_local ThreadPool* localPool = nullptr;
+    static inline thread_local size_t localIndex = 0;
+    static inline thread_local std::minstd_rand localRng;
+    static inline thread_local unsigned runDepth = 0;
+
+    // Order matters:
+    // - Destroy threads -> queues
+    ThreadPoolOptions options;
+    size_t threadCount = 0;
+    std::atomic_bool done;
+    std::atomic_uint32_t wakeEpoch{0};
+    std::atomic_uint32_t sleepers{0};
+    std::vector<std::unique_ptr<NodePool>> nodes;
+    std::vector<size_t> cpuNode;
+    std::vector<size_t> workerNode;
+    std::vector<std::unique_ptr<WorkStealingQueue<PoolTask>>> localQueues;
+#if THREAD_POOL_STATS
+    Clock::time_point started = Clock::now();
+    std::vector<WorkerCounters> counters;
+#endif
+    std::vector<std::thread> threads;
+};
@@ -0,0 +1,327 @@
+#define _GNU_SOURCE // syscall()
+
+#include "bqueue.h"
+
+#include <linux/futex.h>
+#include <sched.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Lock-free BQueue: same queue_* API as bqueue.c, built on C11 atomics.
+// - Vyukov's bounded MPMC ring: a slot's sequence number says whose turn it is, seq == pos means free for the
+//   producer of pos, seq == pos + 1 means full for the consumer of pos.
+// - Blocking calls spin for SPIN_BUDGET rounds, then sleep on a futex eventcount. Wake-ups are only sent when
+//   a waiter is registered, so the uncontended path makes no syscall.
+// - queue_close sets CLOSED_BIT in enqueue_pos, so a producer's claim and its close check are one CAS: every
+//   push happens before the close and consumers drain up to the final enqueue_pos.
+// Source: https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+
+#define CACHE_LINE 64
+#define SPIN_BUDGET 128
+#define CLOSED_BIT (SIZE_MAX ^ (SIZE_MAX >> 1))
+
+typedef struct Slot
+{
+    atomic_size_t seq;
+    int val;
+} Slot;
+
+typedef struct WaitPoint
+{
+    alignas(CACHE_LINE) _Atomic uint32_t epoch;
+    _Atomic uint32_t waiters;
+} WaitPoint;
+
+struct BQueue
+{
+    size_t capacity;
+    Slot* slots;
+
+    alignas(CACHE_LINE) atomic_size_t enqueue_pos; // top bit set once closed
+    alignas(CACHE_LINE) atomic_size_t dequeue_pos;
+    WaitPoint not_empty; // consumer waits for not empty
+    WaitPoint not_full;  // producer waits for not full
+};
+
+static void cpu_relax(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ volatile("yield");
+#endif
+}
+
+static void futex_wait(_Atomic uint32_t* addr, uint32_t expected)
+{
+    syscall(SYS_futex, (uint32_t*)addr, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+static void futex_wake(_Atomic uint32_t* addr, int count)
+{
+    syscall(SYS_futex, (uint32_t*)addr, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+
+// Every position change is a seq_cst CAS followed by a seq_cst load of waiters, and a waiter registers
+// before re-checking the positions, so either the waiter sees the change or the notifier sees the waiter.
+static void wait_point_notify(WaitPoint* wp, int count)
+{
+    if (atomic_load(&wp->waiters) == 0)
+        return;
+
+    atomic_fetch_add_explicit(&wp->epoch, 1, memory_order_release);
+    futex_wake(&wp->epoch, count);
+}
+
+BQueue* queue_init(size_t capacity)
+{
+    BQueue* queue = aligned_alloc(CACHE_LINE, (sizeof(BQueue) + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE);
+    if (!queue)
+        return NULL;
+
+    // With a single slot "full for pos" and "free for pos + 1" would be the same sequence number.
+    queue->capacity = capacity > 2 ? capacity : 2;
+    queue->slots = malloc(queue->capacity * sizeof(Slot));
+    if (!queue->slots)
+    {
+        free(queue);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < queue->capacity; ++i)
+    {
+        atomic_init(&queue->slots[i].seq, i);
+        queue->slots[i].val = 0;
+    }
+
+    atomic_init(&queue->enqueue_pos, 0);
+    atomic_init(&queue->dequeue_pos, 0);
+    atomic_init(&queue->not_empty.epoch, 0);
+    atomic_init(&queue->not_empty.waiters, 0);
+    atomic_init(&queue->not_full.epoch, 0);
+    atomic_init(&queue->not_full.waiters, 0);
+
+    return queue;
+}
+
+void queue_destroy(BQueue* queue)
+{
+    if (!queue)
+        return;
+
+    free(queue->slots);
+    free(queue);
+}
+
+bool queue_empty(BQueue* queue)
+{
+    return !queue || (atomic_load(&queue->enqueue_pos) & ~CLOSED_BIT) == atomic_load(&queue->dequeue_pos);
+}
+
+bool queue_full(BQueue* queue)
+{
+    return queue &&
+           (atomic_load(&queue->enqueue_pos) & ~CLOSED_BIT) - atomic_load(&queue->dequeue_pos) >= queue->capacity;
+}
+
+size_t queue_capacity(BQueue* queue)
+{
+    return queue ? queue->capacity : 0;
+}
+
+void queue_print(const char* text, BQueue* queue)
+{
+    if (queue)
+    {
+        const size_t head = atomic_load(&queue->dequeue_pos) % queue->capacity;
+        const size_t tail = (atomic_load(&queue->enqueue_pos) & ~CLOSED_BIT) % queue->capacity;
+
+        printf("%s [", text);
+        for (size_t i = 0; i < queue->capacity; ++i)
+        {
+            if (i == head && i == tail)
+                printf("HT:%d,", queue->slots[i].val);
+            else if (i == head)
+                printf("H:%d,", queue->slots[i].val);
+            else if (i == tail)
+                printf("T:%d,", queue->slots[i].val);
+            else
+                printf("%d,", queue->slots[i].val);
+        }
+        printf("]\n");
+    }
+}
+
+bool queue_try_push(BQueue* queue, int val)
+{
+    if (!queue)
+        return false;
+
+    size_t pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+    Slot* slot;
+    for (;;)
+    {
+        // A failed CAS reloads pos, so a queue_close between our load and the CAS is seen here.
+        if (pos & CLOSED_BIT)
+            return false;
+
+        slot = &queue->slots[pos % queue->capacity];
+        const size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        const intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0)
+        {
+            if (atomic_compare_exchange_weak(&queue->enqueue_pos, &pos, pos + 1))
+                break;
+        }
+        else if (diff < 0)
+        {
+            return false; // Full
+        }
+        else
+        {
+            pos = atomic_load_explicit(&queue->enqueue_pos, memory_order_relaxed);
+        }
+    }
+
+    slot->val = val;
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+
+    wait_point_notify(&queue->not_empty, 1);
+    return true;
+}
+
+bool queue_try_pop(BQueue* queue, int* val)
+{
+    if (!queue)
+        return false;
+
+    size_t pos = atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+    Slot* slot;
+    for (;;)
+    {
+        slot = &queue->slots[pos % queue->capacity];
+        const size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        const intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (diff == 0)
+        {
+            if (atomic_compare_exchange_weak(&queue->dequeue_pos, &pos, pos + 1))
+                break;
+        }
+        else if (diff < 0)
+        {
+            return false; // Empty
+        }
+        else
+        {
+            pos = atomic_load_explicit(&queue->dequeue_pos, memory_order_relaxed);
+        }
+    }
+
+    if (val) // discards the value if the user doesn't want it
+        *val = slot->val;
+    atomic_store_explicit(&slot->seq, pos + queue->capacity, memory_order_release);
+
+    wait_point_notify(&queue->not_full, 1);
+    return true;
+}
+
+static bool is_closed(BQueue* queue)
+{
+    return atomic_load(&queue->enqueue_pos) & CLOSED_BIT;
+}
+
+// After queue_close no position can be claimed anymore, pops until dequeue_pos reaches the final enqueue_pos.
+// A producer that claimed a slot before the close may still be writing it, we wait for it to publish.
+static bool drain(BQueue* queue, int* val)
+{
+    const size_t last = atomic_load(&queue->enqueue_pos) & ~CLOSED_BIT;
+    for (unsigned spins = 0;; ++spins)
+    {
+        if (queue_try_pop(queue, val))
+            return true;
+
+        if (atomic_load(&queue->dequeue_pos) == last)
+            return false;
+
+        if (spins < SPIN_BUDGET)
+            cpu_relax();
+        else
+            sched_yield();
+    }
+}
+
+bool queue_wait_push(BQueue* queue, int val)
+{
+    if (!queue)
+        return false;
+
+    for (unsigned spins = 0;; ++spins)
+    {
+        if (queue_try_push(queue, val))
+            return true;
+
+        if (is_closed(queue))
+            return false;
+
+        if (spins < SPIN_BUDGET)
+        {
+            cpu_relax();
+            continue;
+        }
+
+        // Sleep only if no consumer has claimed a slot it hasn't handed back yet.
+        const uint32_t epoch = atomic_load_explicit(&queue->not_full.epoch, memory_order_acquire);
+        atomic_fetch_add(&queue->not_full.waiters, 1);
+        const size_t enqueue = atomic_load(&queue->enqueue_pos);
+        if (!(enqueue & CLOSED_BIT) && enqueue - atomic_load(&queue->dequeue_pos) >= queue->capacity)
+            futex_wait(&queue->not_full.epoch, epoch);
+        atomic_fetch_sub_explicit(&queue->not_full.waiters, 1, memory_order_relaxed);
+        spins = 0;
+    }
+}
+
+bool queue_wait_pop(BQueue* queue, int* val)
+{
+    if (!queue)
+        return false;
+
+    for (unsigned spins = 0;; ++spins)
+    {
+        if (queue_try_pop(queue, val))
+            return true;
+
+        if (is_closed(queue))
+            return drain(queue, val);
+
+        if (spins < SPIN_BUDGET)
+        {
+            cpu_relax();
+            continue;
+        }
+
+        // Sleep only if no producer has claimed a slot we haven't consumed yet.
+        const uint32_t epoch = atomic_load_explicit(&queue->not_empty.epoch, memory_order_acquire);
+        atomic_fetch_add(&queue->not_empty.waiters, 1);
+        const size_t enqueue = atomic_load(&queue->enqueue_pos);
+        if (!(enqueue & CLOSED_BIT) && enqueue == atomic_load(&queue->dequeue_pos))
+            futex_wait(&queue->not_empty.epoch, epoch);
+        atomic_fetch_sub_explicit(&queue->not_empty.waiters, 1, memory_order_relaxed);
+        spins = 0;
+    }
+}
+
+void queue_close(BQueue* queue)
+{
+    if (!queue || (atomic_fetch_or(&queue->enqueue_pos, CLOSED_BIT) & CLOSED_BIT))
+        return;
+
+    atomic_fetch_add_explicit(&queue->not_empty.epoch, 1, memory_order_release);
+    futex_wake(&queue->not_empty.epoch, INT32_MAX);
+    atomic_fetch_add_explicit(&queue->not_full.epoch, 1, memory_order_release);
+    futex_wake(&queue->not_full.epoch, INT32_MAX);
+}
@@ -0,0 +1,302 @@
+
+#include "bqueue.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct BQueue
+{
+    size_t capacity;
+    size_t size;
+    size_t head;
+    size_t tail;
+    int* slots;
+
+    pthread_mutex_t mtx;
+    pthread_cond_t not_empty_cond; // consumer waits for not empty
+    pthread_cond_t not_full_cond;  // producer waits for not full
+    bool close;
+};
+
+BQueue* queue_init(size_t capacity)
+{
+    BQueue* queue = malloc(sizeof(BQueue));
+    if (!queue)
+        return NULL;
+
+    queue->capacity = capacity > 0 ? capacity : 1;
+    queue->size = 0;
+    queue->head = 0;
+    queue->tail = 0;
+    queue->close = false;
+
+    int err = pthread_mutex_init(&queue->mtx, NULL);
+    if (err != 0)
+    {
+        printf("pthread_mutex_init err: %s", strerror(err));
+        goto cleanup;
+    }
+
+    err = pthread_cond_init(&queue->not_empty_cond, NULL);
+    if (err != 0)
+    {
+        printf("not_empty_cond pthread_cond_init err: %s", strerror(err));
+        goto cleanup_mtx;
+    }
+
+    err = pthread_cond_init(&queue->not_full_cond, NULL);
+    if (err != 0)
+    {
+        printf("not_full_cond pthread_cond_init err: %s", strerror(err));
+        goto cleanup_cond_not_empty;
+    }
+
+    queue->slots = calloc(queue->capacity, sizeof(int));
+    if (!queue->slots)
+        goto cleanup_cond_not_full;
+
+    return queue;
+
+cleanup_cond_not_full:
+    pthread_cond_destroy(&queue->not_full_cond);
+cleanup_cond_not_empty:
+    pthread_cond_destroy(&queue->not_empty_cond);
+cleanup_mtx:
+    pthread_mutex_destroy(&queue->mtx);
+cleanup:
+    free(queue);
+    return NULL;
+}
+
+void queue_destroy(BQueue* queue)
+{
+    if (!queue)
+        return;
+
+    pthread_cond_destroy(&queue->not_full_cond);
+    pthread_cond_destroy(&queue->not_empty_cond);
+    pthread_mutex_destroy(&queue->mtx);
+    free(queue->slots);
+    free(queue);
+}
+
+bool queue_empty(BQueue* queue)
+{
+    return !queue || queue->size == 0;
+}
+
+bool queue_full(BQueue* queue)
+{
+    return queue && queue->size == queue->capacity;
+}
+
+size_t queue_capacity(BQueue* queue)
+{
+    return queue ? queue->capacity : 0;
+}
+
+void queue_print(const char* text, BQueue* queue)
+{
+    if (queue)
+    {
+        printf("%s [", text);
+        for (int i = 0; i < queue->capacity; ++i)
+        {
+            if (i == queue->head && i == queue->tail)
+                printf("HT:%d,", queue->slots[i]);
+            else if (i == queue->head)
+                printf("H:%d,", queue->slots[i]);
+            else if (i == queue->tail)
+                printf("T:%d,", queue->slots[i]);
+            else
+                printf("%d,", queue->slots[i]);
+        }
+        printf("]\n");
+    }
+}
+
+bool queue_try_push(BQueue* queue, int val)
+{
+    if (!queue || queue_full(queue))
+        return false;
+
+    queue->slots[queue->tail] = val;
+    queue->tail = (queue->tail + 1) % queue->capacity;
+    ++queue->size;
+
+    return true;
+}
+
+bool queue_try_pop(BQueue* queue, int* val)
+{
+    if (!queue || queue_empty(queue))
+        return false;
+
+    if (val) // discards the value if the user doesn't want it
+        *val = queue->slots[queue->head];
+    queue->head = (queue->head + 1) % queue->capacity;
+    --queue->size;
+    return true;
+}
+
+bool queue_wait_push(BQueue* queue, int val)
+{
+    if (!queue)
+        return false;
+
+    int err = pthread_mutex_lock(&queue->mtx);
+    if (err != 0)
+    {
+        printf("queue_wait_push pthread_mutex_lock err!\n");
+        exit(1);
+    }
+
+    while (queue->size == queue->capacity && !queue->close)
+    {
+        err = pthread_cond_wait(&queue->not_full_cond, &queue->mtx);
+        if (err != 0)
+        {
+            printf("queue_wait_push pthread_cond_wait err!\n");
+            exit(1);
+        }
+    }
+
+    if (queue->close)
+    {
+        err = pthread_mutex_unlock(&queue->mtx);
+        if (err != 0)
+        {
+            printf("queue_wait_push (closed) pthread_mutex_unlock err!\n");
+            exit(1);
+        }
+
+        return false;
+    }
+
+    queue->slots[queue->tail] = val;
+    queue->tail = (queue->tail + 1) % queue->capacity;
+    ++queue->size;
+
+    err = pthread_mutex_unlock(&queue->mtx);
+    if (err != 0)
+    {
+        printf("queue_wait_push pthread_mutex_unlock err!\n");
+        exit(1);
+    }
+
+    err = pthread_cond_signal(&queue->not_empty_cond);
+    if (err != 0)
+    {
+        printf("queue_wait_push pthread_cond_signal err!\n");
+        exit(1);
+    }
+
+    return true;
+}
+
+bool queue_wait_pop(BQueue* queue, int* val)
+{
+    if (!queue)
+        return false;
+
+    int err = pthread_mutex_lock(&queue->mtx);
+    if (err != 0)
+    {
+        printf("queue_wait_pop pthread_mutex_lock err!\n");
+        exit(1);
+    }
+
+    while (queue->size == 0 && !queue->close)
+    {
+        err = pthread_cond_wait(&queue->not_empty_cond, &queue->mtx);
+        if (err != 0)
+        {
+            printf("queue_wait_pop pthread_cond_wait err!\n");
+            exit(1);
+        }
+    }
+
+    if (queue->size == 0) // Implies queue->close == true
+    {
+        err = pthread_mutex_unlock(&queue->mtx);
+        if (err != 0)
+        {
+            printf("queue_wait_pop (close) pthread_mutex_unlock err!\n");
+            exit(1);
+        }
+        return false;
+    }
+
+    if (val) // Discards the value if val == NULL
+        *val = queue->slots[queue->head];
+
+    queue->head = (queue->head + 1) % queue->capacity;
+    --queue->size;
+
+    err = pthread_mutex_unlock(&queue->mtx);
+    if (err != 0)
+    {
+        printf("queue_wait_pop pthread_mutex_unlock err!\n");
+        exit(1);
+    }
+
+    err = pthread_cond_signal(&queue->not_full_cond);
+    if (err != 0)
+    {
+        printf("queue_wait_pop pthread_cond_signal err!\n");
+        exit(1);
+    }
+
+    return true;
+}
+
+void queue_close(BQueue* queue)
+{
+    if (!queue)
+        return;
+
+    int err = pthread_mutex_lock(&queue->mtx);
+    if (err != 0)
+    {
+        printf("queue_close pthread_mutex_lock err!\n");
+        exit(1);
+    }
+
+    if (queue->close)
+    {
+        err = pthread_mutex_unlock(&queue->mtx);
+        if (err != 0)
+        {
+            printf("queue_close pthread_mutex_unlock err!\n");
+            exit(1);
+        }
+
+        return;
+    }
+
+    queue->close = true;
+
+    err = pthread_mutex_unlock(&queue->mtx);
+    if (err != 0)
+    {
+        printf("queue_close pthread_mutex_unlock err!\n");
+        exit(1);
+    }
+
+    err = pthread_cond_broadcast(&queue->not_empty_cond);
+    if (err != 0)
+    {
+        printf("queue_close (not_empty_cond) pthread_cond_broadcast err!\n");
+        exit(1);
+    }
+
+    err = pthread_cond_broadcast(&queue->not_full_cond);
+    if (err != 0)
+    {
+        printf("queue_close (not_full_cond) pthread_cond_broadcast err!\n");
+        exit(1);
+    }
+}
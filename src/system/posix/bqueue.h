@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Bounded FIFO of ints.
+// bqueue.c guards it with a mutex and two condition variables, bqueue-atomic.c is lock-free.
+typedef struct BQueue BQueue;
+
+// Returns NULL on failure, capacity is rounded up to 1 (bqueue.c) or 2 (bqueue-atomic.c).
+BQueue* queue_init(size_t capacity);
+void queue_destroy(BQueue* queue);
+
+// Not synchronized in bqueue.c, only for single threaded use.
+bool queue_empty(BQueue* queue);
+bool queue_full(BQueue* queue);
+size_t queue_capacity(BQueue* queue);
+void queue_print(const char* text, BQueue* queue);
+bool queue_try_push(BQueue* queue, int val);
+bool queue_try_pop(BQueue* queue, int* val);
+
+// Block while the queue is full/empty, return false once the queue is closed (and drained for pop).
+bool queue_wait_push(BQueue* queue, int val);
+bool queue_wait_pop(BQueue* queue, int* val);
+void queue_close(BQueue* queue);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,599 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+// Bounded queue of fixed-size byte records shared between processes.
+// - The whole queue (header, mutex, condition variables, slots) lives in a shm_open/mmap segment.
+// - Producers reserve a slot, write the record in place and commit it; consumers acquire the record at the
+//   head, read it in place and release the slot. Nothing is copied through an intermediate buffer.
+// - The mutex is robust: if a process dies while holding it the next locker gets EOWNERDEAD. Slots carry
+//   their owner's pid, so slots held by a dead process are reclaimed on EOWNERDEAD and on periodic wait
+//   timeouts.
+
+#define SHM_QUEUE_MAGIC 0x53485151u
+#define SHM_QUEUE_ALIGN 64
+#define SHM_QUEUE_RECOVERY_MS 100
+#define SHM_QUEUE_OPEN_TIMEOUT_MS 1000
+
+typedef enum SlotState
+{
+    SLOT_FREE,
+    SLOT_WRITING,   // reserved by a producer
+    SLOT_READY,     // committed, waiting for a consumer
+    SLOT_READING,   // acquired by a consumer
+    SLOT_ABANDONED, // its producer died before commit, consumers skip it
+} SlotState;
+
+typedef struct ShmSlot
+{
+    uint32_t state;
+    pid_t owner; // 0 unless WRITING/READING
+    _Alignas(16) unsigned char data[];
+} ShmSlot;
+
+typedef struct ShmQueueHeader
+{
+    uint32_t magic; // set last by the creator, openers wait for it
+    size_t capacity;
+    size_t record_size;
+    size_t slot_size;
+    size_t map_size;
+
+    size_t head;      // next slot to acquire
+    size_t tail;      // next slot to reserve
+    size_t reclaimed; // slots taken back from dead processes
+    bool close;
+
+    pthread_mutex_t mtx;
+    pthread_cond_t not_empty_cond; // consumer waits for a READY head
+    pthread_cond_t not_full_cond;  // producer waits for a FREE tail
+
+    _Alignas(SHM_QUEUE_ALIGN) unsigned char slots[];
+} ShmQueueHeader;
+
+// Per process handle to a mapped queue.
+typedef struct ShmQueue
+{
+    ShmQueueHeader* hdr;
+    size_t map_size;
+} ShmQueue;
+
+static size_t align_up(size_t n, size_t align)
+{
+    return (n + align - 1) / align * align;
+}
+
+static ShmSlot* slot_at(ShmQueueHeader* hdr, size_t pos)
+{
+    return (ShmSlot*)(hdr->slots + (pos % hdr->capacity) * hdr->slot_size);
+}
+
+static ShmSlot* slot_of(ShmQueueHeader* hdr, const void* record)
+{
+    const size_t index = ((const unsigned char*)record - hdr->slots) / hdr->slot_size;
+    return (ShmSlot*)(hdr->slots + index * hdr->slot_size);
+}
+
+static bool process_alive(pid_t pid)
+{
+    return kill(pid, 0) == 0 || errno != ESRCH;
+}
+
+// Called with the mutex held. Returns the number of slots reclaimed, also added to hdr->reclaimed.
+static size_t recover_dead_owners(ShmQueueHeader* hdr)
+{
+    size_t recovered = 0;
+    for (size_t i = 0; i < hdr->capacity; ++i)
+    {
+        ShmSlot* slot = slot_at(hdr, i);
+        if (slot->owner == 0 || process_alive(slot->owner))
+            continue;
+
+        // A half written record is never delivered, a half read one is lost with its reader.
+        slot->state = slot->state == SLOT_WRITING ? SLOT_ABANDONED : SLOT_FREE;
+        slot->owner = 0;
+        ++recovered;
+    }
+
+    hdr->reclaimed += recovered;
+    return recovered;
+}
+
+static void shm_broadcast(pthread_cond_t* cond)
+{
+    int err = pthread_cond_broadcast(cond);
+    if (err != 0)
+    {
+        fprintf(stderr, "shm_queue pthread_cond_broadcast err: %s\n", strerror(err));
+        exit(1);
+    }
+}
+
+// Called with the mutex held. Wakes every waiter, freed or abandoned slots may be what they are waiting for.
+static void shm_wake_all(ShmQueueHeader* hdr)
+{
+    shm_broadcast(&hdr->not_empty_cond);
+    shm_broadcast(&hdr->not_full_cond);
+}
+
+// Called after EOWNERDEAD with the mutex held. Returns the pthread_mutex_consistent error.
+static int recover_mutex(ShmQueueHeader* hdr)
+{
+    recover_dead_owners(hdr);
+    int err = pthread_mutex_consistent(&hdr->mtx);
+    shm_wake_all(hdr);
+    return err;
+}
+
+// Returns true if the previous owner of the mutex died and the queue was recovered.
+static bool shm_lock(ShmQueueHeader* hdr)
+{
+    bool recovered = false;
+    int err = pthread_mutex_lock(&hdr->mtx);
+    if (err == EOWNERDEAD)
+    {
+        recovered = true;
+        err = recover_mutex(hdr);
+    }
+
+    if (err != 0)
+    {
+        fprintf(stderr, "shm_queue pthread_mutex_lock err: %s\n", strerror(err));
+        exit(1);
+    }
+
+    return recovered;
+}
+
+static void shm_unlock(ShmQueueHeader* hdr)
+{
+    int err = pthread_mutex_unlock(&hdr->mtx);
+    if (err != 0)
+    {
+        fprintf(stderr, "shm_queue pthread_mutex_unlock err: %s\n", strerror(err));
+        exit(1);
+    }
+}
+
+// Waits with a timeout, a peer may die without ever signaling us.
+static void shm_wait(ShmQueueHeader* hdr, pthread_cond_t* cond)
+{
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_nsec += SHM_QUEUE_RECOVERY_MS * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    int err = pthread_cond_timedwait(cond, &hdr->mtx, &deadline);
+    if (err == EOWNERDEAD)
+    {
+        err = recover_mutex(hdr);
+    }
+    else if (err == ETIMEDOUT)
+    {
+        if (recover_dead_owners(hdr) != 0)
+            shm_wake_all(hdr);
+        err = 0;
+    }
+
+    if (err != 0)
+    {
+        fprintf(stderr, "shm_queue pthread_cond_timedwait err: %s\n", strerror(err));
+        exit(1);
+    }
+}
+
+static bool init_sync(ShmQueueHeader* hdr)
+{
+    pthread_mutexattr_t mattr;
+    pthread_mutexattr_init(&mattr);
+    pthread_mutexattr_setpshared(&mattr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&mattr, PTHREAD_MUTEX_ROBUST);
+    int err = pthread_mutex_init(&hdr->mtx, &mattr);
+    pthread_mutexattr_destroy(&mattr);
+    if (err != 0)
+    {
+        fprintf(stderr, "pthread_mutex_init err: %s\n", strerror(err));
+        return false;
+    }
+
+    pthread_condattr_t cattr;
+    pthread_condattr_init(&cattr);
+    pthread_condattr_setpshared(&cattr, PTHREAD_PROCESS_SHARED);
+    pthread_condattr_setclock(&cattr, CLOCK_MONOTONIC);
+    err = pthread_cond_init(&hdr->not_empty_cond, &cattr);
+    if (err != 0)
+    {
+        fprintf(stderr, "not_empty_cond pthread_cond_init err: %s\n", strerror(err));
+        goto cleanup_mtx;
+    }
+
+    err = pthread_cond_init(&hdr->not_full_cond, &cattr);
+    if (err != 0)
+    {
+        fprintf(stderr, "not_full_cond pthread_cond_init err: %s\n", strerror(err));
+        goto cleanup_cond_not_empty;
+    }
+
+    pthread_condattr_destroy(&cattr);
+    return true;
+
+cleanup_cond_not_empty:
+    pthread_cond_destroy(&hdr->not_empty_cond);
+cleanup_mtx:
+    pthread_condattr_destroy(&cattr);
+    pthread_mutex_destroy(&hdr->mtx);
+    return false;
+}
+
+// Creates and maps a new segment, fails if name already exists.
+static ShmQueue* shm_queue_create(const char* name, size_t capacity, size_t record_size)
+{
+    capacity = capacity > 0 ? capacity : 1;
+    const size_t slot_size = align_up(sizeof(ShmSlot) + record_size, SHM_QUEUE_ALIGN);
+    const size_t map_size = sizeof(ShmQueueHeader) + capacity * slot_size;
+
+    ShmQueue* queue = malloc(sizeof(ShmQueue));
+    if (!queue)
+        return NULL;
+
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd == -1)
+    {
+        fprintf(stderr, "shm_open(%s) err: %s\n", name, strerror(errno));
+        goto cleanup;
+    }
+
+    if (ftruncate(fd, (off_t)map_size) == -1)
+    {
+        fprintf(stderr, "ftruncate err: %s\n", strerror(errno));
+        goto cleanup_fd;
+    }
+
+    ShmQueueHeader* hdr = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (hdr == MAP_FAILED)
+    {
+        fprintf(stderr, "mmap err: %s\n", strerror(errno));
+        goto cleanup_fd;
+    }
+    close(fd);
+
+    // ftruncate zero fills, every slot starts FREE without an owner.
+    hdr->capacity = capacity;
+    hdr->record_size = record_size;
+    hdr->slot_size = slot_size;
+    hdr->map_size = map_size;
+    hdr->head = 0;
+    hdr->tail = 0;
+    hdr->reclaimed = 0;
+    hdr->close = false;
+    if (!init_sync(hdr))
+    {
+        munmap(hdr, map_size);
+        shm_unlink(name);
+        free(queue);
+        return NULL;
+    }
+
+    __atomic_store_n(&hdr->magic, SHM_QUEUE_MAGIC, __ATOMIC_RELEASE);
+
+    queue->hdr = hdr;
+    queue->map_size = map_size;
+    return queue;
+
+cleanup_fd:
+    close(fd);
+    shm_unlink(name);
+cleanup:
+    free(queue);
+    return NULL;
+}
+
+// Maps an existing segment, waits until its creator has initialized it.
+static ShmQueue* shm_queue_open(const char* name)
+{
+    ShmQueue* queue = malloc(sizeof(ShmQueue));
+    if (!queue)
+        return NULL;
+
+    int fd = shm_open(name, O_RDWR, 0600);
+    if (fd == -1)
+    {
+        fprintf(stderr, "shm_open(%s) err: %s\n", name, strerror(errno));
+        goto cleanup;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(ShmQueueHeader))
+    {
+        fprintf(stderr, "shm_queue_open: segment not ready\n");
+        goto cleanup_fd;
+    }
+
+    ShmQueueHeader* hdr = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (hdr == MAP_FAILED)
+    {
+        fprintf(stderr, "mmap err: %s\n", strerror(errno));
+        goto cleanup_fd;
+    }
+    close(fd);
+
+    // The creator may die before it's done, don't wait for it forever.
+    struct timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (__atomic_load_n(&hdr->magic, __ATOMIC_ACQUIRE) != SHM_QUEUE_MAGIC)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        const long elapsed_ms = (now.tv_sec - start.tv_sec) * 1000L + (now.tv_nsec - start.tv_nsec) / 1000000L;
+        if (elapsed_ms >= SHM_QUEUE_OPEN_TIMEOUT_MS)
+        {
+            fprintf(stderr, "shm_queue_open(%s): segment never initialized\n", name);
+            munmap(hdr, (size_t)st.st_size);
+            goto cleanup;
+        }
+        sched_yield();
+    }
+
+    queue->hdr = hdr;
+    queue->map_size = (size_t)st.st_size;
+    return queue;
+
+cleanup_fd:
+    close(fd);
+cleanup:
+    free(queue);
+    return NULL;
+}
+
+// Number of slots reclaimed from dead processes so far.
+static size_t shm_queue_reclaimed(ShmQueue* queue)
+{
+    ShmQueueHeader* hdr = queue->hdr;
+    shm_lock(hdr);
+    const size_t reclaimed = hdr->reclaimed;
+    shm_unlock(hdr);
+    return reclaimed;
+}
+
+// Unmaps the segment in this process, shm_unlink() removes the name.
+static void shm_queue_unmap(ShmQueue* queue)
+{
+    if (!queue)
+        return;
+
+    munmap(queue->hdr, queue->map_size);
+    free(queue);
+}
+
+// Returns a record_size buffer inside the segment to write in place, NULL once the queue is closed.
+static void* shm_queue_reserve(ShmQueue* queue)
+{
+    ShmQueueHeader* hdr = queue->hdr;
+    shm_lock(hdr);
+
+    while (slot_at(hdr, hdr->tail)->state != SLOT_FREE && !hdr->close)
+        shm_wait(hdr, &hdr->not_full_cond);
+
+    if (hdr->close)
+    {
+        shm_unlock(hdr);
+        return NULL;
+    }
+
+    ShmSlot* slot = slot_at(hdr, hdr->tail++);
+    slot->state = SLOT_WRITING;
+    slot->owner = getpid();
+
+    shm_unlock(hdr);
+    return slot->data;
+}
+
+// Publishes a record returned by shm_queue_reserve.
+static void shm_queue_commit(ShmQueue* queue, void* record)
+{
+    ShmQueueHeader* hdr = queue->hdr;
+    shm_lock(hdr);
+
+    ShmSlot* slot = slot_of(hdr, record);
+    slot->state = SLOT_READY;
+    slot->owner = 0;
+
+    shm_unlock(hdr);
+
+    // Commits can finish out of order, only the consumer waiting for the head slot can make progress.
+    shm_broadcast(&hdr->not_empty_cond);
+}
+
+// Returns the oldest record to read in place, NULL once the queue is closed and drained.
+static const void* shm_queue_acquire(ShmQueue* queue)
+{
+    ShmQueueHeader* hdr = queue->hdr;
+    shm_lock(hdr);
+
+    bool skipped = false;
+    for (;;)
+    {
+        ShmSlot* slot = slot_at(hdr, hdr->head);
+        if (hdr->head != hdr->tail && slot->state == SLOT_ABANDONED)
+        {
+            slot->state = SLOT_FREE;
+            ++hdr->head;
+            skipped = true;
+            continue;
+        }
+
+        if ((hdr->head != hdr->tail && slot->state == SLOT_READY) || (hdr->close && hdr->head == hdr->tail))
+            break;
+
+        shm_wait(hdr, &hdr->not_empty_cond);
+    }
+
+    const void* record = NULL;
+    if (hdr->head != hdr->tail)
+    {
+        ShmSlot* slot = slot_at(hdr, hdr->head++);
+        slot->state = SLOT_READING;
+        slot->owner = getpid();
+        record = slot->data;
+    }
+
+    shm_unlock(hdr);
+
+    if (skipped)
+        shm_broadcast(&hdr->not_full_cond);
+
+    return record;
+}
+
+// Hands a record returned by shm_queue_acquire back to the producers.
+static void shm_queue_release(ShmQueue* queue, const void* record)
+{
+    ShmQueueHeader* hdr = queue->hdr;
+    shm_lock(hdr);
+
+    ShmSlot* slot = slot_of(hdr, record);
+    slot->state = SLOT_FREE;
+    slot->owner = 0;
+
+    shm_unlock(hdr);
+
+    shm_broadcast(&hdr->not_full_cond);
+}
+
+// Wakes everybody, reserve fails from now on and acquire fails once the queue is drained.
+static void shm_queue_close(ShmQueue* queue)
+{
+    ShmQueueHeader* hdr = queue->hdr;
+    shm_lock(hdr);
+    hdr->close = true;
+    shm_unlock(hdr);
+
+    shm_broadcast(&hdr->not_empty_cond);
+    shm_broadcast(&hdr->not_full_cond);
+}
+
+typedef struct Message
+{
+    pid_t sender;
+    int seq;
+    char text[48];
+} Message;
+
+static const char* SHM_NAME = "/posix-shm-bounded-queue-demo";
+static const int PROD_COUNT = 1000;
+
+static void produce(void)
+{
+    ShmQueue* queue = shm_queue_open(SHM_NAME);
+    if (!queue)
+        exit(1);
+
+    for (int i = 1; i <= PROD_COUNT; ++i)
+    {
+        Message* msg = shm_queue_reserve(queue);
+        if (!msg)
+            break;
+
+        msg->sender = getpid();
+        msg->seq = i;
+        snprintf(msg->text, sizeof(msg->text), "message %d", i);
+        shm_queue_commit(queue, msg);
+    }
+
+    shm_queue_unmap(queue);
+    exit(0);
+}
+
+// Dies holding the mutex and a reserved slot.
+static void crash(void)
+{
+    ShmQueue* queue = shm_queue_open(SHM_NAME);
+    if (!queue)
+        exit(1);
+
+    Message* msg = shm_queue_reserve(queue);
+    if (msg)
+        msg->seq = -1;
+
+    shm_lock(queue->hdr);
+    _exit(0);
+}
+
+int main()
+{
+    shm_unlink(SHM_NAME); // leftover of a killed run
+    ShmQueue* queue = shm_queue_create(SHM_NAME, 8, sizeof(Message));
+    if (!queue)
+        return 1;
+
+    // Reaped right away, kill(pid, 0) can't tell a zombie from a live process.
+    pid_t crasher = fork();
+    if (crasher == 0)
+        crash();
+    if (crasher == -1 || waitpid(crasher, NULL, 0) == -1)
+    {
+        perror("fork");
+        exit(1);
+    }
+
+    pid_t producer = fork();
+    if (producer == 0)
+        produce();
+    if (producer == -1)
+    {
+        perror("fork");
+        exit(1);
+    }
+
+    int expected = 1;
+    bool in_order = true;
+    for (int received = 0; received < PROD_COUNT && in_order; ++received)
+    {
+        const Message* msg = shm_queue_acquire(queue);
+        if (!msg)
+        {
+            fprintf(stderr, "Queue closed after %d of %d messages\n", received, PROD_COUNT);
+            in_order = false;
+            break;
+        }
+
+        if (msg->sender != producer || msg->seq != expected)
+        {
+            fprintf(stderr, "Expected message %d from process %d, got %d from process %d\n", expected, (int)producer,
+                    msg->seq, (int)msg->sender);
+            in_order = false;
+        }
+        ++expected;
+        shm_queue_release(queue, msg);
+    }
+
+    if (in_order)
+        printf("Received %d messages in order from process %d\n", expected - 1, (int)producer);
+    printf("Reclaimed %zu slots of dead processes\n", shm_queue_reclaimed(queue));
+
+    shm_queue_close(queue);
+    waitpid(producer, NULL, 0);
+
+    shm_queue_unmap(queue);
+    shm_unlink(SHM_NAME);
+
+    if (!in_order)
+        return 1;
+
+    printf("Done.\n");
+    return 0;
+}